@@ -0,0 +1,289 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include "source/fast/atomic/atomic_push_queue.h"
+#include "source/fast/threading/inter_thread_queue.h"
+
+namespace benchmark {
+
+/* Producers stamp every item with the time of the push, consumers
+ * record the time until the pop as latency. Throughput is the number
+ * of items divided by the time from the start signal until the last
+ * item was popped.
+ */
+
+template<std::size_t Size>
+struct payload {
+    static_assert(Size >= sizeof(std::uint64_t), "payload holds a stamp");
+
+    std::uint64_t stamp;
+    char data[Size - sizeof(std::uint64_t)];
+};
+
+template<>
+struct payload<sizeof(std::uint64_t)> {
+    std::uint64_t stamp;
+};
+
+struct result {
+    std::string queue;
+    unsigned int producers;
+    unsigned int consumers;
+    std::size_t item_size;
+    bool pinned;
+    std::size_t items;
+    double ops_per_second;
+    std::uint64_t p50;
+    std::uint64_t p99;
+    std::uint64_t p999;
+};
+
+// adapters give every queue the same try_pop interface, 0 is no limit
+
+template<class Item>
+struct push_queue {
+    static constexpr unsigned int max_producers = 0;
+    static constexpr unsigned int max_consumers = 1;
+
+    void push(Item&& item) {
+        queue.push(std::move(item));
+    }
+
+    bool try_pop(Item& item) {
+        return queue.pop(item);
+    }
+
+    fast::atomic_push_queue<Item> queue;
+};
+
+template<class Item>
+struct inter_thread {
+    static constexpr unsigned int max_producers = 1;
+    static constexpr unsigned int max_consumers = 1;
+
+    void push(Item&& item) {
+        queue.push(std::move(item));
+    }
+
+    bool try_pop(Item& item) {
+        if (queue.available() == 0) {
+            return false;
+        }
+        item = std::move(queue.top());
+        queue.pop();
+        return true;
+    }
+
+    fast::inter_thread_queue<Item> queue;
+};
+
+template<class Item>
+struct mutex_deque {
+    static constexpr unsigned int max_producers = 0;
+    static constexpr unsigned int max_consumers = 0;
+
+    void push(Item&& item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(item));
+    }
+
+    bool try_pop(Item& item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queue.empty()) {
+            return false;
+        }
+        item = std::move(queue.front());
+        queue.pop_front();
+        return true;
+    }
+
+    std::mutex mutex;
+    std::deque<Item> queue;
+};
+
+inline std::uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+// best effort, threads stay unpinned where it isn't supported
+inline void pin(std::thread& thread, unsigned int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#elif defined(_WIN32)
+    SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << cpu);
+#else
+    (void)thread;
+    (void)cpu;
+#endif
+}
+
+inline std::uint64_t percentile(
+    std::vector<std::uint64_t>& samples, double fraction
+) {
+    if (samples.empty()) {
+        return 0;
+    }
+
+    std::size_t index = std::min(
+        samples.size() - 1, std::size_t(fraction * samples.size())
+    );
+    std::nth_element(
+        samples.begin(), samples.begin() + index, samples.end()
+    );
+    return samples[index];
+}
+
+template<template<class> class Queue, std::size_t Size>
+bool supported(unsigned int producers, unsigned int consumers) {
+    typedef Queue<payload<Size>> queue_type;
+    return
+        (queue_type::max_producers == 0 ||
+        producers <= queue_type::max_producers) &&
+        (queue_type::max_consumers == 0 ||
+        consumers <= queue_type::max_consumers);
+}
+
+template<template<class> class Queue, std::size_t Size>
+result run(
+    const std::string& name, unsigned int producers, unsigned int consumers,
+    bool pinned, std::size_t items
+) {
+    typedef payload<Size> item_type;
+
+    Queue<item_type> queue;
+    std::atomic<unsigned int> ready(0);
+    std::atomic_bool go(false);
+    std::atomic<std::size_t> consumed(0);
+    std::vector<std::vector<std::uint64_t>> latencies(consumers);
+    std::vector<std::thread> threads;
+
+    auto start = [&]() {
+        ready++;
+        while (!go.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    };
+
+    for (unsigned int p = 0; p < producers; p++) {
+        // the first producers push one more if it doesn't divide
+        std::size_t count = items / producers + (p < items % producers);
+        threads.emplace_back([&queue, &start, count]() {
+            start();
+            for (std::size_t i = 0; i < count; i++) {
+                item_type item;
+                item.stamp = now();
+                queue.push(std::move(item));
+            }
+        });
+    }
+
+    for (unsigned int c = 0; c < consumers; c++) {
+        std::vector<std::uint64_t>& samples = latencies[c];
+        samples.reserve(items / consumers + 1);
+        threads.emplace_back([&, items]() {
+            start();
+            item_type item;
+            while (consumed.load(std::memory_order_relaxed) < items) {
+                if (queue.try_pop(item)) {
+                    samples.push_back(now() - item.stamp);
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    if (pinned) {
+        unsigned int cpus = std::max(1u, std::thread::hardware_concurrency());
+        for (std::size_t i = 0; i < threads.size(); i++) {
+            pin(threads[i], static_cast<unsigned int>(i % cpus));
+        }
+    }
+
+    while (ready.load() < threads.size()) {
+        std::this_thread::yield();
+    }
+    std::uint64_t begin = now();
+    go.store(true, std::memory_order_release);
+
+    for (auto& t : threads) {
+        t.join();
+    }
+    std::uint64_t end = now();
+
+    std::vector<std::uint64_t> samples;
+    samples.reserve(items);
+    for (auto& l : latencies) {
+        samples.insert(samples.end(), l.begin(), l.end());
+    }
+
+    result r;
+    r.queue = name;
+    r.producers = producers;
+    r.consumers = consumers;
+    r.item_size = sizeof(item_type);
+    r.pinned = pinned;
+    r.items = items;
+    r.ops_per_second = items / ((end - begin) / 1e9);
+    r.p50 = percentile(samples, 0.5);
+    r.p99 = percentile(samples, 0.99);
+    r.p999 = percentile(samples, 0.999);
+    return r;
+}
+
+inline void write_csv_header(std::ostream& out) {
+    out <<
+        "queue,producers,consumers,item_size,pinned,items,"
+        "ops_per_second,p50_ns,p99_ns,p999_ns\n";
+}
+
+inline void write_csv(std::ostream& out, const result& r) {
+    out << r.queue << ',' << r.producers << ',' << r.consumers << ','
+        << r.item_size << ',' << r.pinned << ',' << r.items << ','
+        << std::uint64_t(r.ops_per_second) << ',' << r.p50 << ','
+        << r.p99 << ',' << r.p999 << '\n';
+}
+
+// one object per line, so results can be appended and streamed
+inline void write_json(std::ostream& out, const result& r) {
+    out << "{\"queue\":\"" << r.queue << "\""
+        << ",\"producers\":" << r.producers
+        << ",\"consumers\":" << r.consumers
+        << ",\"item_size\":" << r.item_size
+        << ",\"pinned\":" << (r.pinned ? "true" : "false")
+        << ",\"items\":" << r.items
+        << ",\"ops_per_second\":" << std::uint64_t(r.ops_per_second)
+        << ",\"p50_ns\":" << r.p50
+        << ",\"p99_ns\":" << r.p99
+        << ",\"p999_ns\":" << r.p999 << "}\n";
+}
+
+}
+
+#endif // BENCHMARK_H
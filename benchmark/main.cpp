@@ -0,0 +1,112 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "benchmark.h"
+
+/* Sweeps producer and consumer counts, item sizes and pinning for
+ * every queue that supports the combination.
+ *
+ * usage: fast [--items n] [--format csv|json] [--output file] [--quick]
+ */
+
+namespace {
+    struct options {
+        std::size_t items = 200000;
+        bool json = false;
+        bool quick = false;
+        std::string output;
+    };
+
+    struct sweep {
+        const options& o;
+        std::ostream& out;
+
+        template<template<class> class Queue, std::size_t Size>
+        void queue(const std::string& name) {
+            const unsigned int all[] = {1, 2, 4, 8};
+            unsigned int counts = o.quick ? 2 : 4;
+
+            for (int pinned = 0; pinned < 2; pinned++) {
+                for (unsigned int p = 0; p < counts; p++) {
+                    for (unsigned int c = 0; c < counts - 1; c++) {
+                        if (!benchmark::supported<Queue, Size>(
+                            all[p], all[c]
+                        )) {
+                            continue;
+                        }
+
+                        benchmark::result r = benchmark::run<Queue, Size>(
+                            name, all[p], all[c], pinned != 0, o.items
+                        );
+                        if (o.json) {
+                            benchmark::write_json(out, r);
+                        } else {
+                            benchmark::write_csv(out, r);
+                        }
+                        out.flush();
+                    }
+                }
+            }
+        }
+
+        template<std::size_t Size>
+        void size() {
+            queue<benchmark::push_queue, Size>("atomic_push_queue");
+            queue<benchmark::inter_thread, Size>("inter_thread_queue");
+            queue<benchmark::mutex_deque, Size>("mutex_deque");
+        }
+    };
+
+    bool parse(int argc, char* argv[], options& o) {
+        for (int i = 1; i < argc; i++) {
+            bool has_value = i + 1 < argc;
+            if (std::strcmp(argv[i], "--items") == 0 && has_value) {
+                o.items = std::strtoull(argv[++i], nullptr, 10);
+            } else if (std::strcmp(argv[i], "--format") == 0 && has_value) {
+                o.json = std::strcmp(argv[++i], "json") == 0;
+            } else if (std::strcmp(argv[i], "--output") == 0 && has_value) {
+                o.output = argv[++i];
+            } else if (std::strcmp(argv[i], "--quick") == 0) {
+                o.quick = true;
+            } else {
+                return false;
+            }
+        }
+        return o.items > 0;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    options o;
+    if (!parse(argc, argv, o)) {
+        std::cerr <<
+            "usage: " << argv[0] <<
+            " [--items n] [--format csv|json] [--output file] [--quick]\n";
+        return 1;
+    }
+
+    std::ofstream file;
+    if (!o.output.empty()) {
+        file.open(o.output);
+        if (!file) {
+            std::cerr << "can't open " << o.output << '\n';
+            return 1;
+        }
+    }
+    std::ostream& out = o.output.empty() ? std::cout : file;
+
+    if (!o.json) {
+        benchmark::write_csv_header(out);
+    }
+
+    sweep s{o, out};
+    s.size<16>();
+    if (!o.quick) {
+        s.size<64>();
+        s.size<256>();
+    }
+    return 0;
+}
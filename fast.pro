@@ -10,30 +10,80 @@ SOURCES +=
 HEADERS += \
     source/fast/atomic/atomic_push_queue.h \
     source/fast/atomic/atomic_unique_ptr.h \
+    source/fast/atomic/atomic_tagged_ptr.h \
+    source/fast/atomic/epoch.h \
     source/fast/threading/inter_thread_queue.h \
+    source/fast/threading/bounded_queue.h \
+    source/fast/threading/work_stealing_deque.h \
+    source/fast/threading/thread_pool.h \
+    source/fast/threading/fan_in_queue.h \
     source/fast/threading/semaphore.h \
     source/fast/collections/span.h \
     source/fast/collections/arrays.h \
+    source/fast/collections/arrays_tiled.h \
+    source/fast/collections/mapped_arrays.h \
+    source/fast/collections/column_kernels.h \
+    source/fast/collections/parallel_arrays.h \
     source/fast/collections/tuple.h \
     source/fast/utility/observable.h \
     source/fast/utility/unique_link.h \
-    source/fast/collections/unordered_vector.h
+    source/fast/utility/cache_line.h \
+    source/fast/utility/contention.h \
+    source/fast/collections/unordered_vector.h \
+    source/fast/collections/slot_vector.h
+
+# qmake CONFIG+=coroutines builds as C++20 with the coroutine layer
+coroutines {
+    CONFIG -= c++14
+    CONFIG += c++2a
+    QMAKE_CXXFLAGS -= -std=c++14
+    QMAKE_CXXFLAGS += -std=c++20
+
+    HEADERS += \
+        source/fast/coroutine/scheduler.h \
+        source/fast/coroutine/async_semaphore.h \
+        source/fast/coroutine/async_queue.h
+}
 
 test {
     SOURCES += test/main.cpp
     HEADERS += \
         test/atomic/atomic_push_queue_test.h \
         test/atomic/atomic_unique_ptr_test.h \
+        test/atomic/atomic_tagged_ptr_test.h \
+        test/atomic/epoch_test.h \
         test/threading/inter_thread_queue_test.h \
+        test/threading/bounded_queue_test.h \
+        test/threading/work_stealing_deque_test.h \
+        test/threading/thread_pool_test.h \
+        test/threading/fan_in_queue_test.h \
         test/collections/span_test.h \
         test/collections/arrays_test.h \
+        test/collections/arrays_tiled_test.h \
+        test/collections/mapped_arrays_test.h \
+        test/collections/column_kernels_test.h \
+        test/collections/parallel_arrays_test.h \
         test/threading/semaphore_test.h \
         test/utility/observable_test.h \
         test/utility/unique_link_test.h \
-        test/collections/unordered_vector_test.h
+        test/collections/unordered_vector_test.h \
+        test/collections/slot_vector_test.h
+
+    coroutines {
+        HEADERS += \
+            test/coroutine/scheduler_test.h \
+            test/coroutine/async_semaphore_test.h \
+            test/coroutine/async_queue_test.h
+    }
 
     QMAKE_CXXFLAGS += -fprofile-arcs -ftest-coverage
     QMAKE_LFLAGS += -lgcov --coverage
+} else:benchmark {
+    # qmake CONFIG+=benchmark, options are listed in benchmark/main.cpp
+    CONFIG += release
+    CONFIG -= debug
+    SOURCES += benchmark/main.cpp
+    HEADERS += benchmark/benchmark.h
 } else {
     SOURCES += source/main.cpp
 }
@@ -3,108 +3,425 @@
 
 #include <atomic>
 #include <cassert>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
 
-#include "atomic_unique_ptr.h"
+#include "atomic_tagged_ptr.h"
+#include "../utility/contention.h"
 
 namespace fast {
 
 template<class Item>
-struct atomic_push_queue {
+struct atomic_push_queue : private contention_counters {
     atomic_push_queue();
     ~atomic_push_queue();
 
+    atomic_push_queue(const atomic_push_queue&) = delete;
+
+    atomic_push_queue& operator=(const atomic_push_queue&) = delete;
+
     void push(Item&& i);
     bool pop(Item& i);
 
+    /**
+     * @brief push all items in [first, last) with a single insertion
+     * The items are copied, use std::make_move_iterator to move them.
+     * The range is read twice, so Iterator has to be a forward iterator.
+     */
+    template<class Iterator>
+    void push_range(Iterator first, Iterator last);
+
+    /**
+     * @brief move all available items to out
+     * @return out after the last written item
+     */
+    template<class OutputIterator>
+    OutputIterator pop_all(OutputIterator out);
+
+    /**
+     * @brief call function with every available item as an rvalue
+     * @return the number of consumed items
+     */
+    template<class Function>
+    std::size_t consume_all(Function function);
+
+    /**
+     * @brief allocate nodes until at least n are pooled
+     * @param n The number of pushes that should not allocate
+     */
+    void reserve(std::size_t n);
+
+    /**
+     * @return the number of nodes available to push without allocation
+     */
+    std::size_t pool_size() const;
+
+    /**
+     * @return the counters enabled by FAST_CONTENTION_COUNTERS,
+     * all zero otherwise
+     */
+    contention_snapshot contention() const;
+
 private:
+    // an empty base unless enabled, so disabled counters take no space
+    contention_counters& counters();
+    const contention_counters& counters() const;
+
     struct node {
-        atomic_unique_ptr<node> next;
+        std::atomic<node*> next;
         Item value;
     };
 
+    // takes up to count linked nodes from the pool, returns how many
+    std::size_t allocate(std::size_t count, node*& first, node*& last);
+    void link(node* first);
+    // returns the next node to consume, or nullptr if none is available
+    node* take(bool swap);
+    void recycle(node* first, node* last, std::size_t count);
+    static void destroy(node* first);
+
     // alternate between two linked lists
-    atomic_unique_ptr<node> lists[2];
+    std::atomic<node*> lists[2];
     std::atomic_int readers[2];
 
     // next to be popped
-    atomic_unique_ptr<node>* next;
+    std::atomic<node*>* next;
+    // last popped node and number of popped nodes of the list being read
+    node* last;
+    std::size_t popped;
 
     // list to push to
     std::atomic_bool index;
+
+    // stack of unused nodes, nodes are only deleted by the destructor
+    atomic_tagged_ptr<node> pool;
+    std::atomic<std::size_t> pooled;
 };
 
 template<class Item>
 atomic_push_queue<Item>::atomic_push_queue() :
-    next(lists + 1), index(0)
+    next(lists + 1), last(nullptr), popped(0), index(0), pooled(0)
 {
+    lists[0] = nullptr;
+    lists[1] = nullptr;
     readers[0] = 0;
     readers[1] = 0;
 }
 
 template<class Item>
 atomic_push_queue<Item>::~atomic_push_queue() {
+    destroy(lists[0].load());
+    destroy(lists[1].load());
+    destroy(pool.load().get());
 }
 
 template<class Item>
 void atomic_push_queue<Item>::push(Item&& item) {
-    node* new_node = new node {{nullptr}, item};
+    node* new_node;
+    node* last;
+    if (allocate(1, new_node, last) == 1) {
+        new_node->value = std::move(item);
+    } else {
+        new_node = new node{{nullptr}, std::move(item)};
+        counters().block_allocation();
+    }
+
+    counters().pushed(1);
+    link(new_node);
+}
+
+template<class Item>
+bool atomic_push_queue<Item>::pop(Item& item) {
+    node* n = take(true);
+    if (n == nullptr) {
+        counters().empty_poll();
+        return false;
+    }
+
+    // the node goes back to the pool, so the value doesn't need to survive
+    item = std::move(n->value);
+    return true;
+}
+
+template<class Item> template<class Iterator>
+void atomic_push_queue<Item>::push_range(Iterator first, Iterator last) {
+    // the range is counted before it is copied, so it's read twice
+    static_assert(std::is_base_of<
+        std::forward_iterator_tag,
+        typename std::iterator_traits<Iterator>::iterator_category
+    >::value, "push_range needs a forward iterator");
+
+    std::size_t count = std::distance(first, last);
+    if (count == 0) {
+        return;
+    }
+
+    node* first_node;
+    node* last_node;
+    std::size_t reused = allocate(count, first_node, last_node);
+    std::size_t chained = reused;
+
+    try {
+        node* n = first_node;
+        for (std::size_t i = 0; i < reused; i++, ++first) {
+            n->value = *first;
+            n = n->next.load(std::memory_order_relaxed);
+        }
+
+        // build the chain completely before linking it in one exchange
+        for (; first != last; ++first) {
+            node* new_node = new node{{nullptr}, *first};
+            counters().block_allocation();
+            if (first_node == nullptr) {
+                first_node = new_node;
+            } else {
+                last_node->next.store(new_node, std::memory_order_relaxed);
+            }
+            last_node = new_node;
+            chained++;
+        }
+    } catch (...) {
+        // nothing was pushed, the chain built so far goes to the pool
+        if (chained > 0) {
+            recycle(first_node, last_node, chained);
+        }
+        throw;
+    }
+
+    counters().pushed(count);
+    link(first_node);
+}
+
+template<class Item> template<class OutputIterator>
+OutputIterator atomic_push_queue<Item>::pop_all(OutputIterator out) {
+    consume_all([&out](Item&& item) {
+        *out = std::move(item);
+        ++out;
+    });
+    return out;
+}
+
+template<class Item> template<class Function>
+std::size_t atomic_push_queue<Item>::consume_all(Function function) {
+    std::size_t count = 0;
+    node* n;
+
+    // drain the list being read, then swap at most once so that
+    // continuous pushing can't keep this from returning
+    while ((n = take(false)) != nullptr) {
+        function(std::move(n->value));
+        count++;
+    }
+
+    n = take(true);
+    while (n != nullptr) {
+        function(std::move(n->value));
+        count++;
+        n = take(false);
+    }
+
+    if (count == 0) {
+        counters().empty_poll();
+    }
+    return count;
+}
+
+template<class Item>
+void atomic_push_queue<Item>::reserve(std::size_t n) {
+    std::size_t size = pool_size();
+    if (size >= n) {
+        return;
+    }
+
+    node* last = new node{{nullptr}, Item()};
+    node* first = last;
+    for (std::size_t i = size + 1; i < n; i++) {
+        first = new node{{first}, Item()};
+    }
+
+    recycle(first, last, n - size);
+}
+
+template<class Item>
+std::size_t atomic_push_queue<Item>::pool_size() const {
+    return pooled.load(std::memory_order_relaxed);
+}
+
+template<class Item>
+contention_counters& atomic_push_queue<Item>::counters() {
+    return *this;
+}
+
+template<class Item>
+const contention_counters& atomic_push_queue<Item>::counters() const {
+    return *this;
+}
+
+template<class Item>
+contention_snapshot atomic_push_queue<Item>::contention() const {
+    return counters().snapshot();
+}
+
+template<class Item>
+std::size_t atomic_push_queue<Item>::allocate(
+    std::size_t count, node*& first, node*& last
+) {
+    tagged_ptr<node> top = pool.load(std::memory_order_acquire);
+    node* rest;
+    std::size_t taken;
+
+    while (true) {
+        // nodes may be taken concurrently, but are never deleted, so reading
+        // next is safe, the tag makes the exchange fail in that case
+        first = top.get();
+        last = nullptr;
+        rest = first;
+        taken = 0;
+        while (rest != nullptr && taken < count) {
+            last = rest;
+            rest = rest->next.load(std::memory_order_relaxed);
+            taken++;
+        }
 
-    bool index = this->index.load();
-    int count = readers[index].fetch_add(1);
-    assert(count >= 0);
+        if (taken == 0 || pool.compare_exchange_weak(
+            top, rest, std::memory_order_acquire, std::memory_order_acquire
+        )) {
+            break;
+        }
+        // another thread moved the top, or a spurious failure
+        counters().cas_retry();
+    }
+
+    if (taken > 0) {
+        pooled.fetch_sub(taken, std::memory_order_relaxed);
+        last->next.store(nullptr, std::memory_order_relaxed);
+    }
+
+    return taken;
+}
+
+template<class Item>
+void atomic_push_queue<Item>::link(node* first) {
+    bool index;
+    while (true) {
+        index = this->index.load();
+        int count = readers[index].fetch_add(1);
+        assert(count >= 0);
+
+        if (this->index.load() == index) {
+            break;
+        }
+
+        // lists were swapped in between, this one might be getting recycled
+        readers[index].fetch_sub(1);
+        counters().cas_retry();
+    }
 
-    atomic_unique_ptr<node>* n = &lists[index];
+    std::atomic<node*>* n = &lists[index];
     node* expected = nullptr;
 
-    while (!n->compare_exchange_weak(expected, new_node)) {
-        if (expected != nullptr) {
-            // compare_exchange_weak may fail spuriously
-            n = &expected->next;
-            expected = nullptr;
+    // only the readers counters and index need sequential consistency,
+    // the chain just has to be published to the consumer
+    while (true) {
+        // walk to the tail with loads, only the exchange there can collide
+        node* tail;
+        while ((tail = n->load(std::memory_order_acquire)) != nullptr) {
+            n = &tail->next;
         }
+
+        if (n->compare_exchange_weak(
+            expected, first,
+            std::memory_order_release, std::memory_order_relaxed
+        )) {
+            break;
+        }
+        // another push got in first, or a spurious failure
+        counters().cas_retry();
+        expected = nullptr;
     }
 
-    count = readers[index].fetch_sub(1);
+    int count = readers[index].fetch_sub(1);
     assert(count >= 1);
 }
 
 template<class Item>
-bool atomic_push_queue<Item>::pop(Item& item) {
-    bool result = false;
+typename atomic_push_queue<Item>::node*
+atomic_push_queue<Item>::take(bool swap) {
+    node* n = next->load(std::memory_order_acquire);
 
-    node* n = next->load();
-    if (n != nullptr) {
-        next = &n->next;
-        item = n->value;
-        result = true;
-
-    } else {
+    if (n == nullptr && swap) {
         bool index = this->index.load();
         int count = readers[!index].fetch_add(1);
         assert(count >= 0);
 
         if (count == 0) {
-            // no thread is reading the inactive list right now
-            // delete it
-            lists[!index].store(nullptr);
+            // a push that passed its index check before the last swap
+            // may have appended to this list after the load above
+            n = next->load(std::memory_order_acquire);
+        }
+
+        if (count == 0 && n == nullptr) {
+            // no thread is writing to the inactive list right now
+            // move its nodes to the pool
+            node* first =
+                lists[!index].exchange(nullptr, std::memory_order_acquire);
+            if (first != nullptr) {
+                recycle(first, last, popped);
+            }
+            last = nullptr;
+            popped = 0;
+
             // make empty list the active list
             this->index.store(!index);
 
             next = lists + index;
-
-            n = next->load();
-            if (n != nullptr) {
-                next = &n->next;
-                item = n->value;
-                result = true;
-            }
+            n = next->load(std::memory_order_acquire);
+        } else if (count != 0) {
+            counters().swap_failure();
         }
 
         count = readers[!index].fetch_sub(1);
         assert(count >= 1);
     }
 
-    return result;
+    if (n != nullptr) {
+        next = &n->next;
+        last = n;
+        popped++;
+        counters().popped(1);
+    }
+
+    return n;
+}
+
+template<class Item>
+void atomic_push_queue<Item>::recycle(
+    node* first, node* last, std::size_t count
+) {
+    // count before publishing so pool_size can't underflow
+    pooled.fetch_add(count, std::memory_order_relaxed);
+
+    tagged_ptr<node> top = pool.load(std::memory_order_relaxed);
+    last->next.store(top.get(), std::memory_order_relaxed);
+    while (!pool.compare_exchange_weak(
+        top, first, std::memory_order_release, std::memory_order_relaxed
+    )) {
+        counters().cas_retry();
+        last->next.store(top.get(), std::memory_order_relaxed);
+    }
+}
+
+template<class Item>
+void atomic_push_queue<Item>::destroy(node* first) {
+    // iterative, long lists would overflow the stack otherwise
+    while (first != nullptr) {
+        node* next = first->next.load(std::memory_order_relaxed);
+        delete first;
+        first = next;
+    }
 }
 
 }
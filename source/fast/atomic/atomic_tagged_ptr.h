@@ -0,0 +1,262 @@
+#ifndef ATOMIC_TAGGED_PTR_H
+#define ATOMIC_TAGGED_PTR_H
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+
+namespace fast {
+
+/* The tag lives in the bits above the address. On 64 bit
+ * platforms user space addresses fit in 48 bits, so the tag has
+ * 16 bits and wraps after 65536 modifications, 32 bit platforms
+ * get a 32 bit tag. Addresses above 48 bits, from 5-level paging
+ * (LA57) or pointer tagging (ARM TBI, MTE), can't be stored:
+ * pack aborts instead of dropping them, even in release builds.
+ */
+static_assert(
+    sizeof(void*) == 8 || sizeof(void*) == 4,
+    "atomic_tagged_ptr packs 32 or 64 bit pointers"
+);
+
+namespace detail {
+    constexpr unsigned int tagged_pointer_bits =
+        sizeof(void*) == 8 ? 48 : 32;
+    constexpr std::uint64_t tagged_pointer_mask =
+        (std::uint64_t(1) << tagged_pointer_bits) - 1;
+}
+
+template<class T>
+struct tagged_ptr {
+    tagged_ptr();
+    tagged_ptr(T* pointer, std::uint64_t tag = 0);
+
+    T* get() const noexcept;
+    // only the lowest 64 - detail::tagged_pointer_bits bits are kept,
+    // 16 on 64 bit platforms, so the tag wraps
+    std::uint64_t tag() const noexcept;
+
+    T& operator*() const;
+    T* operator->() const;
+
+    bool operator==(const tagged_ptr& rhs) const noexcept;
+    bool operator!=(const tagged_ptr& rhs) const noexcept;
+
+private:
+    template<class>
+    friend struct atomic_tagged_ptr;
+
+    explicit tagged_ptr(std::uint64_t bits, int);
+
+    static std::uint64_t pack(T* pointer, std::uint64_t tag);
+
+    std::uint64_t bits;
+};
+
+template<class T>
+struct atomic_tagged_ptr {
+    /* Pointer with a version counter that is incremented
+     * by every modification. A compare exchange therefore fails
+     * if the pointer was changed and changed back in between,
+     * which makes it safe for lock-free stacks and free lists.
+     * Doesn't own the object pointed to.
+     */
+
+    atomic_tagged_ptr();
+    atomic_tagged_ptr(T* pointer);
+
+    atomic_tagged_ptr(atomic_tagged_ptr const&) = delete;
+
+    atomic_tagged_ptr& operator=(atomic_tagged_ptr const&) = delete;
+
+    tagged_ptr<T> load(
+        std::memory_order order = std::memory_order_seq_cst
+    ) const noexcept;
+    void store(
+        T* desired, std::memory_order order = std::memory_order_seq_cst
+    ) noexcept;
+    tagged_ptr<T> exchange(
+        T* desired, std::memory_order order = std::memory_order_seq_cst
+    ) noexcept;
+
+    /**
+     * @brief replace expected with desired, with the tag of expected + 1
+     * @return true on success, otherwise expected is updated
+     */
+    bool compare_exchange_weak(
+        tagged_ptr<T>& expected, T* desired,
+        std::memory_order success, std::memory_order failure
+    ) noexcept;
+    bool compare_exchange_weak(
+        tagged_ptr<T>& expected, T* desired,
+        std::memory_order order = std::memory_order_seq_cst
+    ) noexcept;
+    bool compare_exchange_strong(
+        tagged_ptr<T>& expected, T* desired,
+        std::memory_order success, std::memory_order failure
+    ) noexcept;
+    bool compare_exchange_strong(
+        tagged_ptr<T>& expected, T* desired,
+        std::memory_order order = std::memory_order_seq_cst
+    ) noexcept;
+
+    bool is_lock_free() const noexcept;
+
+private:
+    static std::memory_order failure_order(std::memory_order order);
+
+    std::atomic<std::uint64_t> bits;
+};
+
+
+template<class T>
+tagged_ptr<T>::tagged_ptr() : bits(0) {}
+
+template<class T>
+tagged_ptr<T>::tagged_ptr(T* pointer, std::uint64_t tag) :
+    bits(pack(pointer, tag)) {}
+
+template<class T>
+tagged_ptr<T>::tagged_ptr(std::uint64_t bits, int) : bits(bits) {}
+
+template<class T>
+std::uint64_t tagged_ptr<T>::pack(T* pointer, std::uint64_t tag) {
+    std::uint64_t address = reinterpret_cast<std::uintptr_t>(pointer);
+    if ((address & ~detail::tagged_pointer_mask) != 0) {
+        // the high bits would be lost, the pointer would change silently
+        assert(false && "pointer doesn't fit in tagged_pointer_bits");
+        std::abort();
+    }
+    // tag overflows into nothing
+    return address | tag << detail::tagged_pointer_bits;
+}
+
+template<class T>
+T* tagged_ptr<T>::get() const noexcept {
+    return reinterpret_cast<T*>(
+        static_cast<std::uintptr_t>(bits & detail::tagged_pointer_mask)
+    );
+}
+
+template<class T>
+std::uint64_t tagged_ptr<T>::tag() const noexcept {
+    return bits >> detail::tagged_pointer_bits;
+}
+
+template<class T>
+T& tagged_ptr<T>::operator*() const {
+    return *get();
+}
+
+template<class T>
+T* tagged_ptr<T>::operator->() const {
+    return get();
+}
+
+template<class T>
+bool tagged_ptr<T>::operator==(const tagged_ptr& rhs) const noexcept {
+    return bits == rhs.bits;
+}
+
+template<class T>
+bool tagged_ptr<T>::operator!=(const tagged_ptr& rhs) const noexcept {
+    return bits != rhs.bits;
+}
+
+template<class T>
+atomic_tagged_ptr<T>::atomic_tagged_ptr() : bits(0) {}
+
+template<class T>
+atomic_tagged_ptr<T>::atomic_tagged_ptr(T* pointer) :
+    bits(tagged_ptr<T>(pointer).bits) {}
+
+template<class T>
+tagged_ptr<T> atomic_tagged_ptr<T>::load(
+    std::memory_order order
+) const noexcept {
+    return tagged_ptr<T>(bits.load(order), 0);
+}
+
+template<class T>
+void atomic_tagged_ptr<T>::store(
+    T* desired, std::memory_order order
+) noexcept {
+    exchange(desired, order);
+}
+
+template<class T>
+tagged_ptr<T> atomic_tagged_ptr<T>::exchange(
+    T* desired, std::memory_order order
+) noexcept {
+    // the tag has to be incremented, so this can't be a plain exchange
+    tagged_ptr<T> expected = load(std::memory_order_relaxed);
+    while (!compare_exchange_weak(
+        expected, desired, order, std::memory_order_relaxed
+    )) {}
+    return expected;
+}
+
+template<class T>
+bool atomic_tagged_ptr<T>::compare_exchange_weak(
+    tagged_ptr<T>& expected, T* desired,
+    std::memory_order success, std::memory_order failure
+) noexcept {
+    return bits.compare_exchange_weak(
+        expected.bits, tagged_ptr<T>(desired, expected.tag() + 1).bits,
+        success, failure
+    );
+}
+
+template<class T>
+bool atomic_tagged_ptr<T>::compare_exchange_weak(
+    tagged_ptr<T>& expected, T* desired, std::memory_order order
+) noexcept {
+    return compare_exchange_weak(
+        expected, desired, order, failure_order(order)
+    );
+}
+
+template<class T>
+bool atomic_tagged_ptr<T>::compare_exchange_strong(
+    tagged_ptr<T>& expected, T* desired,
+    std::memory_order success, std::memory_order failure
+) noexcept {
+    return bits.compare_exchange_strong(
+        expected.bits, tagged_ptr<T>(desired, expected.tag() + 1).bits,
+        success, failure
+    );
+}
+
+template<class T>
+bool atomic_tagged_ptr<T>::compare_exchange_strong(
+    tagged_ptr<T>& expected, T* desired, std::memory_order order
+) noexcept {
+    return compare_exchange_strong(
+        expected, desired, order, failure_order(order)
+    );
+}
+
+template<class T>
+bool atomic_tagged_ptr<T>::is_lock_free() const noexcept {
+    return bits.is_lock_free();
+}
+
+template<class T>
+std::memory_order atomic_tagged_ptr<T>::failure_order(
+    std::memory_order order
+) {
+    // same rule as std::atomic, the failure order can't contain release
+    switch (order) {
+    case std::memory_order_acq_rel:
+        return std::memory_order_acquire;
+    case std::memory_order_release:
+        return std::memory_order_relaxed;
+    default:
+        return order;
+    }
+}
+
+}
+
+#endif // ATOMIC_TAGGED_PTR_H
@@ -3,6 +3,8 @@
 
 #include <atomic>
 
+#include "epoch.h"
+
 namespace fast {
 
 template<class T>
@@ -20,7 +22,49 @@ struct atomic_unique_ptr {
     void store(
         T* pointer, std::memory_order order = std::memory_order_seq_cst
     ) noexcept;
-    bool compare_exchange_weak(T*& expected, T* desired);
+
+    /**
+     * @brief store desired without deleting the old value
+     * @return the old value, which is now owned by the caller
+     */
+    T* exchange(
+        T* desired, std::memory_order order = std::memory_order_seq_cst
+    ) noexcept;
+    // give up ownership, nullptr is stored instead
+    T* release(std::memory_order order = std::memory_order_seq_cst) noexcept;
+
+    /**
+     * @brief store desired if the current value is expected
+     * On success the caller owns the old value, nothing is deleted.
+     */
+    bool compare_exchange_weak(
+        T*& expected, T* desired,
+        std::memory_order success, std::memory_order failure
+    ) noexcept;
+    bool compare_exchange_weak(
+        T*& expected, T* desired,
+        std::memory_order order = std::memory_order_seq_cst
+    ) noexcept;
+    bool compare_exchange_strong(
+        T*& expected, T* desired,
+        std::memory_order success, std::memory_order failure
+    ) noexcept;
+    bool compare_exchange_strong(
+        T*& expected, T* desired,
+        std::memory_order order = std::memory_order_seq_cst
+    ) noexcept;
+
+    /**
+     * @brief store desired and delete the old value once no epoch_guard
+     * of the thread's domain can reference it anymore
+     */
+    void retire(
+        T* desired, std::memory_order order = std::memory_order_seq_cst
+    );
+    void retire(
+        T* desired, epoch_thread& thread,
+        std::memory_order order = std::memory_order_seq_cst
+    );
 
     const std::atomic<T*>* const_data() const noexcept;
 
@@ -58,8 +102,60 @@ void atomic_unique_ptr<T>::store(T* desired, std::memory_order order) noexcept {
 }
 
 template<class T>
-bool atomic_unique_ptr<T>::compare_exchange_weak(T*& expected, T* desired) {
-    return pointer.compare_exchange_weak(expected, desired);
+T* atomic_unique_ptr<T>::exchange(T* desired, std::memory_order order) noexcept {
+    return pointer.exchange(desired, order);
+}
+
+template<class T>
+T* atomic_unique_ptr<T>::release(std::memory_order order) noexcept {
+    return pointer.exchange(nullptr, order);
+}
+
+template<class T>
+bool atomic_unique_ptr<T>::compare_exchange_weak(
+    T*& expected, T* desired,
+    std::memory_order success, std::memory_order failure
+) noexcept {
+    return pointer.compare_exchange_weak(expected, desired, success, failure);
+}
+
+template<class T>
+bool atomic_unique_ptr<T>::compare_exchange_weak(
+    T*& expected, T* desired, std::memory_order order
+) noexcept {
+    return pointer.compare_exchange_weak(expected, desired, order);
+}
+
+template<class T>
+bool atomic_unique_ptr<T>::compare_exchange_strong(
+    T*& expected, T* desired,
+    std::memory_order success, std::memory_order failure
+) noexcept {
+    return pointer.compare_exchange_strong(
+        expected, desired, success, failure
+    );
+}
+
+template<class T>
+bool atomic_unique_ptr<T>::compare_exchange_strong(
+    T*& expected, T* desired, std::memory_order order
+) noexcept {
+    return pointer.compare_exchange_strong(expected, desired, order);
+}
+
+template<class T>
+void atomic_unique_ptr<T>::retire(T* desired, std::memory_order order) {
+    retire(desired, epoch_thread::current(), order);
+}
+
+template<class T>
+void atomic_unique_ptr<T>::retire(
+    T* desired, epoch_thread& thread, std::memory_order order
+) {
+    T* old = pointer.exchange(desired, order);
+    if (old != nullptr && old != desired) {
+        thread.retire(old);
+    }
 }
 
 template<class T>
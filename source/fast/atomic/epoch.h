@@ -0,0 +1,266 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace fast {
+
+/* Epoch based memory reclamation.
+ * Readers enter a critical section with an epoch_guard before
+ * loading shared pointers. Writers retire unlinked objects instead
+ * of deleting them. An object retired in epoch e is deleted once the
+ * global epoch reached e + 2, since by then every thread that could
+ * have seen it has left its critical section.
+ */
+
+struct epoch_thread;
+
+struct epoch_domain {
+    friend struct epoch_thread;
+    friend struct epoch_guard;
+
+    epoch_domain();
+    // no thread may be registered anymore
+    ~epoch_domain();
+
+    epoch_domain(const epoch_domain&) = delete;
+
+    epoch_domain& operator=(const epoch_domain&) = delete;
+
+    // domain used by epoch_thread::current
+    static epoch_domain& global();
+
+    std::uint64_t epoch() const;
+
+private:
+    struct retired {
+        void* pointer;
+        void (*deleter)(void*);
+    };
+
+    struct limbo {
+        std::uint64_t epoch;
+        std::vector<retired> items;
+
+        void free();
+    };
+
+    struct record {
+        // epoch observed on entering the critical section shifted by one,
+        // lowest bit is set while inside
+        std::atomic<std::uint64_t> state;
+        std::atomic_bool in_use;
+        record* next;
+
+        // owning thread only
+        unsigned int nesting;
+        std::size_t retired_count;
+        limbo limbos[3];
+
+        record();
+    };
+
+    record* acquire();
+    bool try_advance();
+
+    std::atomic<std::uint64_t> global_epoch;
+    // records are never removed, only released for reuse
+    std::atomic<record*> records;
+};
+
+struct epoch_thread {
+    friend struct epoch_guard;
+
+    /**
+     * @brief register the calling thread with domain
+     * Only the constructing thread may use this object.
+     */
+    epoch_thread(epoch_domain& domain);
+    ~epoch_thread();
+
+    epoch_thread(const epoch_thread&) = delete;
+
+    epoch_thread& operator=(const epoch_thread&) = delete;
+
+    // registration of the calling thread with epoch_domain::global
+    static epoch_thread& current();
+
+    /**
+     * @brief delete pointer once no critical section can reference it
+     * The pointer has to be unreachable for threads entering a critical
+     * section after this call.
+     */
+    template<class T>
+    void retire(T* pointer);
+    void retire(void* pointer, void (*deleter)(void*));
+
+    // try to advance the epoch and delete objects that became safe
+    void collect();
+
+private:
+    // retires between attempts to advance the epoch
+    static constexpr std::size_t collect_interval = 64;
+
+    epoch_domain& domain;
+    epoch_domain::record* r;
+};
+
+struct epoch_guard {
+    // enter a critical section, guards may be nested
+    epoch_guard(epoch_thread& thread = epoch_thread::current());
+    ~epoch_guard();
+
+    epoch_guard(const epoch_guard&) = delete;
+
+    epoch_guard& operator=(const epoch_guard&) = delete;
+
+private:
+    epoch_domain::record* r;
+};
+
+
+inline epoch_domain::record::record() :
+    state(0), in_use(true), next(nullptr), nesting(0), retired_count(0),
+    limbos{{0, {}}, {0, {}}, {0, {}}}
+{}
+
+inline void epoch_domain::limbo::free() {
+    for (auto& r : items) {
+        r.deleter(r.pointer);
+    }
+    items.clear();
+}
+
+inline epoch_domain::epoch_domain() : global_epoch(0), records(nullptr) {}
+
+inline epoch_domain::~epoch_domain() {
+    record* r = records.load();
+    while (r != nullptr) {
+        assert(!r->in_use.load());
+        for (auto& l : r->limbos) {
+            l.free();
+        }
+        record* next = r->next;
+        delete r;
+        r = next;
+    }
+}
+
+inline epoch_domain& epoch_domain::global() {
+    static epoch_domain domain;
+    return domain;
+}
+
+inline std::uint64_t epoch_domain::epoch() const {
+    return global_epoch.load(std::memory_order_acquire);
+}
+
+inline epoch_domain::record* epoch_domain::acquire() {
+    // reuse a record of a thread that unregistered, including its
+    // retired objects
+    for (record* r = records.load(); r != nullptr; r = r->next) {
+        bool in_use = false;
+        if (
+            !r->in_use.load(std::memory_order_relaxed) &&
+            r->in_use.compare_exchange_strong(in_use, true)
+        ) {
+            return r;
+        }
+    }
+
+    record* r = new record();
+    record* head = records.load();
+    do {
+        r->next = head;
+    } while (!records.compare_exchange_weak(head, r));
+    return r;
+}
+
+inline bool epoch_domain::try_advance() {
+    std::uint64_t epoch = global_epoch.load();
+
+    for (record* r = records.load(); r != nullptr; r = r->next) {
+        std::uint64_t state = r->state.load();
+        if ((state & 1) != 0 && state >> 1 != epoch) {
+            // still inside a critical section of an older epoch
+            return false;
+        }
+    }
+
+    return global_epoch.compare_exchange_strong(epoch, epoch + 1);
+}
+
+inline epoch_thread::epoch_thread(epoch_domain& domain) :
+    domain(domain), r(domain.acquire()) {}
+
+inline epoch_thread::~epoch_thread() {
+    assert(r->nesting == 0);
+    collect();
+    // remaining objects are deleted by the next owner or the domain
+    r->in_use.store(false, std::memory_order_release);
+}
+
+inline epoch_thread& epoch_thread::current() {
+    static thread_local epoch_thread thread(epoch_domain::global());
+    return thread;
+}
+
+template<class T>
+void epoch_thread::retire(T* pointer) {
+    retire(pointer, [](void* p) {
+        delete static_cast<T*>(p);
+    });
+}
+
+inline void epoch_thread::retire(void* pointer, void (*deleter)(void*)) {
+    std::uint64_t epoch = domain.epoch();
+    epoch_domain::limbo& l = r->limbos[epoch % 3];
+
+    if (l.epoch != epoch) {
+        // bucket holds objects from at least three epochs ago
+        l.free();
+        l.epoch = epoch;
+    }
+    l.items.push_back({pointer, deleter});
+
+    if (++r->retired_count >= collect_interval) {
+        collect();
+    }
+}
+
+inline void epoch_thread::collect() {
+    r->retired_count = 0;
+    domain.try_advance();
+
+    std::uint64_t epoch = domain.epoch();
+    for (auto& l : r->limbos) {
+        if (l.epoch + 2 <= epoch) {
+            l.free();
+        }
+    }
+}
+
+inline epoch_guard::epoch_guard(epoch_thread& thread) : r(thread.r) {
+    if (r->nesting++ == 0) {
+        std::uint64_t epoch =
+            thread.domain.global_epoch.load(std::memory_order_relaxed);
+        r->state.store(epoch << 1 | 1, std::memory_order_relaxed);
+        // announcement has to be visible before any shared pointer is read
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+inline epoch_guard::~epoch_guard() {
+    if (--r->nesting == 0) {
+        std::uint64_t state = r->state.load(std::memory_order_relaxed);
+        r->state.store(state & ~std::uint64_t(1), std::memory_order_release);
+    }
+}
+
+}
+
+#endif // EPOCH_H
@@ -1,41 +1,184 @@
 #ifndef ARRAYS_H
 #define ARRAYS_H
 
+#include <algorithm>
+#include <cassert>
 #include <tuple>
 #include <memory>
 #include <iterator>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <vector>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 #include "span.h"
-#include "tuple.h"
 
 namespace fast {
 
 template<class... Types>
-struct arrays {
-    struct iterator : public std::iterator<
-        std::bidirectional_iterator_tag, std::tuple<Types&&...>
-    > {
+struct arrays_view;
+
+namespace detail {
+    template<class... Types>
+    constexpr size_t max_alignment();
+    // position of Type in Types
+    template<class Type, class... Types>
+    constexpr std::size_t type_index();
+    template<std::size_t Alignment, class... Types>
+    constexpr size_t padding_rows();
+
+    // rows are proxies, rvalues only move what can't be copied
+    template<class Type>
+    std::conditional_t<
+        std::is_copy_constructible<Type>::value, const Type&, Type&&
+    >
+    copy_or_move(Type& value);
+}
+
+// vector registers are at most this wide, AVX-512 uses all of it
+constexpr std::size_t simd_alignment = 64;
+
+template<class... Types>
+struct arrays_reference : public std::tuple<Types&...> {
+    /* A row of an arrays, as returned by its iterators.
+     * Assignment and swap go through to the elements, so
+     * std::sort and friends can permute rows. It's a tuple of
+     * references, std::get and the tuple comparisons work on it
+     * like on value_type.
+     */
+
+    typedef std::tuple<Types...> value_type;
+
+    explicit arrays_reference(Types&... elements);
+    arrays_reference(const arrays_reference& other) = default;
+    arrays_reference(arrays_reference&& other) = default;
+
+    /* Assign the elements, not the references. Dereferenced
+     * iterators are rvalues whether std::move was used or not,
+     * so an rvalue row only moves the elements of types that
+     * can't be copied. std::sort works with move-only columns
+     * and *a = *b doesn't empty b.
+     */
+    const arrays_reference& operator=(const arrays_reference& other) const;
+    const arrays_reference& operator=(arrays_reference&& other) const;
+    const arrays_reference& operator=(const value_type& value) const;
+    const arrays_reference& operator=(value_type&& value) const;
+
+    // copy of the row, an rvalue only moves what can't be copied
+    operator value_type() const &;
+    operator value_type() &&;
+
+    friend void swap(arrays_reference a, arrays_reference b) {
+        a.swap_elements(b, std::index_sequence_for<Types...>());
+    }
+
+private:
+    template<class Tuple, size_t... I>
+    void copy_from(const Tuple& other, std::index_sequence<I...>) const;
+    template<class Tuple, size_t... I>
+    void move_from(Tuple& other, std::index_sequence<I...>) const;
+    template<size_t... I>
+    void take_from(
+        const arrays_reference& other, std::index_sequence<I...>
+    ) const;
+    template<size_t... I>
+    void swap_elements(arrays_reference& other, std::index_sequence<I...>);
+    template<size_t... I>
+    value_type copy(std::index_sequence<I...>) const;
+    template<size_t... I>
+    value_type take(std::index_sequence<I...>);
+};
+
+template<std::size_t Alignment, class... Types>
+struct aligned_arrays {
+    // a row, assignable and swappable, see arrays_reference
+    typedef arrays_reference<Types...> reference;
+
+    struct iterator {
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef std::tuple<Types...> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef void pointer;
+        typedef typename aligned_arrays::reference reference;
+
         iterator();
-        iterator(const std::tuple<Types*...>& data);
-
-        std::tuple<Types&&...> operator*();
-        void operator++();
-        void operator--();
-        iterator operator+(std::ptrdiff_t value);
-        iterator operator-(std::ptrdiff_t value);
-        std::ptrdiff_t operator-(const iterator& rhs);
+        iterator(const std::tuple<Types*...>& columns, size_t row);
+
+        reference operator*() const;
+        reference operator[](std::ptrdiff_t n) const;
+
+        iterator& operator++();
+        iterator operator++(int);
+        iterator& operator--();
+        iterator operator--(int);
+        iterator& operator+=(std::ptrdiff_t n);
+        iterator& operator-=(std::ptrdiff_t n);
+        iterator operator+(std::ptrdiff_t n) const;
+        iterator operator-(std::ptrdiff_t n) const;
+        std::ptrdiff_t operator-(const iterator& rhs) const;
+
         bool operator==(const iterator& rhs) const;
         bool operator!=(const iterator& rhs) const;
+        bool operator<(const iterator& rhs) const;
+        bool operator>(const iterator& rhs) const;
+        bool operator<=(const iterator& rhs) const;
+        bool operator>=(const iterator& rhs) const;
+
+        friend iterator operator+(std::ptrdiff_t n, const iterator& i) {
+            return i + n;
+        }
 
     private:
-        std::tuple<Types*...> data;
+        template<size_t... I>
+        reference dereference(size_t row, std::index_sequence<I...>) const;
+
+        std::tuple<Types*...> columns;
+        size_t row;
     };
 
+    static_assert(sizeof...(Types) > 0, "arrays needs at least one column");
+    static_assert(
+        Alignment > 0 && (Alignment & (Alignment - 1)) == 0,
+        "the alignment has to be a power of two"
+    );
+
+    aligned_arrays();
+    aligned_arrays(aligned_arrays&& other) noexcept;
+    ~aligned_arrays();
+
+    aligned_arrays(const aligned_arrays&) = delete;
+
+    aligned_arrays& operator=(aligned_arrays&& other) noexcept;
+    aligned_arrays& operator=(const aligned_arrays&) = delete;
+
+    // the elements of one column
     template<class Type>
     span<Type> get();
 
     template<int N>
-    typename std::tuple_element<N, std::tuple<Types...>>::type get();
+    span<typename std::tuple_element<N, std::tuple<Types...>>::type> get();
+
+    template<class Type>
+    span<const Type> get() const;
+
+    template<int N>
+    span<const typename std::tuple_element<N, std::tuple<Types...>>::type>
+    get() const;
+
+    /**
+     * @brief iterable over some columns, by index or by type
+     * The view is invalidated like an iterator.
+     */
+    template<int... N>
+    arrays_view<typename std::tuple_element<N, std::tuple<Types...>>::type...>
+    view();
+    template<class... Selected>
+    arrays_view<Selected...> view();
 
     size_t size() const;
     size_t capacity() const;
@@ -44,207 +187,1030 @@ struct arrays {
     iterator end() const;
 
     iterator insert(std::tuple<Types&&...> value);
+    /**
+     * @brief construct a row at the end, one argument per column
+     * @return iterator to the new row
+     */
+    template<class... Args>
+    iterator emplace_back(Args&&... args);
+    // moves the last row into i
     iterator erase(iterator i);
 
+    /**
+     * @brief make room for at least capacity rows, never shrinks
+     * The capacity is rounded up so every column ends on a multiple
+     * of Alignment bytes.
+     */
+    void reserve(size_t capacity);
+    // release the capacity beyond size
+    void shrink_to_fit();
+
+    /**
+     * @brief stable sort of the rows by column N
+     * Integral keys with the default comparison use a radix sort,
+     * every other column is moved once, after the keys are sorted.
+     */
+    template<int N, class Compare = std::less<>>
+    void sort_by(Compare compare = Compare());
+    /**
+     * @brief row i becomes the old row permutation[i], in every column
+     * @param permutation Each row index exactly once
+     */
+    void apply_permutation(span<const std::uint32_t> permutation);
+
 private:
-    std::tuple<unique_span<Types>...> data;
-    iterator end_iterator;
+    /* All columns share one allocation of raw storage, each
+     * starting at Alignment or the alignment of its type.
+     * Elements are constructed by insert and destroyed by erase,
+     * growth moves them or copies their bytes if that is allowed.
+     */
+
+    static constexpr size_t column_count = sizeof...(Types);
+    static constexpr size_t base_alignment =
+        Alignment > detail::max_alignment<Types...>() ?
+            Alignment : detail::max_alignment<Types...>();
+    // operator new only aligns to max_align_t, the rest is done by hand
+    static constexpr size_t extra_bytes =
+        base_alignment > alignof(std::max_align_t) ? base_alignment : 0;
+    typedef std::index_sequence_for<Types...> indices;
+
+    static size_t padded(size_t capacity);
+
+    template<size_t... I>
+    iterator insert(std::tuple<Types&&...>& value, std::index_sequence<I...>);
+
+    void reallocate(size_t capacity);
+    // move the rows to new_columns and free the old storage
+    void adopt(
+        void* new_memory, const std::tuple<Types*...>& new_columns,
+        size_t capacity
+    );
+    // storage for capacity rows, columns is set to its columns
+    void* allocate(size_t capacity, std::tuple<Types*...>& columns);
+    // fills offsets and returns the size of the allocation
+    static size_t layout(size_t capacity, size_t (&offsets)[column_count]);
+
+    template<size_t... I>
+    std::tuple<Types*...> place(
+        char* memory, const size_t (&offsets)[column_count],
+        std::index_sequence<I...>
+    );
+    template<size_t... I>
+    void relocate(const std::tuple<Types*...>& to, std::index_sequence<I...>);
+    template<size_t... I>
+    void gather(
+        const std::tuple<Types*...>& to, const std::uint32_t* permutation,
+        std::index_sequence<I...>
+    );
+    // the row after the last one, in columns or in new storage
+    template<size_t... I, class... Args>
+    void construct(
+        const std::tuple<Types*...>& to, std::index_sequence<I...>,
+        Args&&... args
+    );
+    template<size_t... I>
+    void move_row(size_t from, size_t to, std::index_sequence<I...>);
+    template<size_t... I>
+    void destroy(size_t first, size_t last, std::index_sequence<I...>);
+
+    // as returned by operator new, the columns may start later
+    void* memory;
+    std::tuple<Types*...> columns;
+    size_t rows;
+    size_t reserved;
 };
 
-namespace detail {
-    // functors
-    struct incrementer {
-        template<class Type>
-        Type& operator()(Type& i);
-    };
+template<class... Types>
+struct arrays_view {
+    /* Some columns of an arrays. Iterators only carry and
+     * dereference the selected columns, so narrow passes over
+     * wide tables don't pay for the others.
+     */
 
-    struct decrementer {
-        template<class Type>
-        Type& operator()(Type& i);
-    };
+    struct iterator {
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::tuple<Types&...> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef void pointer;
+        typedef std::tuple<Types&...> reference;
 
-    struct adder {
-        std::ptrdiff_t diff;
+        iterator();
+        iterator(const std::tuple<Types*...>& columns, size_t row);
 
-        adder(std::ptrdiff_t diff = 0);
+        std::tuple<Types&...> operator*() const;
+        iterator& operator++();
+        iterator operator++(int);
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
 
-        template<class Type>
-        Type operator()(const Type& i);
-    };
+    private:
+        template<size_t... I>
+        std::tuple<Types&...> dereference(std::index_sequence<I...>) const;
 
-    struct unique_span_beginner {
-        template<class Type>
-        Type* operator()(const unique_span<Type>& s);
+        std::tuple<Types*...> columns;
+        size_t row;
     };
 
-    struct unique_span_ender {
-        template<class Type>
-        Type* operator()(const unique_span<Type>& s);
-    };
+    arrays_view(const std::tuple<Types*...>& columns, size_t rows);
 
-    struct pointer_referencer {
-        template<class Type>
-        Type&& operator()(Type* p);
-    };
-}
+    template<int N>
+    span<typename std::tuple_element<N, std::tuple<Types...>>::type>
+    get() const;
 
+    size_t size() const;
 
-template<class... Types>
-arrays<Types...>::iterator::iterator() : data(
-    std::make_tuple(static_cast<Types*>(nullptr)...)
-) {}
+    iterator begin() const;
+    iterator end() const;
+
+private:
+    std::tuple<Types*...> columns;
+    size_t rows;
+};
 
+// columns at the natural alignment of their types
 template<class... Types>
-arrays<Types...>::iterator::iterator(const std::tuple<Types*...>& data) :
-    data(data) {}
+using arrays = aligned_arrays<1, Types...>;
 
+// columns aligned and padded for vector loads, see column_kernels.h
 template<class... Types>
-std::tuple<Types&&...> arrays<Types...>::iterator::operator*() {
-    return map(data, detail::pointer_referencer());
+using simd_arrays = aligned_arrays<simd_alignment, Types...>;
+
+namespace detail {
+    template<class... Types>
+    constexpr size_t max_alignment() {
+        const size_t alignments[] = {alignof(Types)...};
+        size_t result = 1;
+        for (size_t a : alignments) {
+            result = a > result ? a : result;
+        }
+        return result;
+    }
+
+    // rows after which every column ends on a multiple of Alignment
+    template<std::size_t Alignment, class... Types>
+    constexpr size_t padding_rows() {
+        const size_t sizes[] = {sizeof(Types)...};
+        size_t result = 1;
+        for (size_t size : sizes) {
+            size_t rows = Alignment;
+            while (rows > 1 && size * (rows / 2) % Alignment == 0) {
+                rows /= 2;
+            }
+            result = rows > result ? rows : result;
+        }
+        return result;
+    }
+
+    template<class Type, class... Types>
+    constexpr std::size_t type_index() {
+        const bool same[] = {std::is_same<Type, Types>::value...};
+        std::size_t index = 0;
+        while (index < sizeof...(Types) && !same[index]) {
+            index++;
+        }
+        return index;
+    }
+
+    constexpr size_t align_up(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // move count elements to uninitialized storage and end the old ones
+    template<class Type>
+    void relocate(Type* from, Type* to, size_t count, std::true_type);
+    template<class Type>
+    void relocate(Type* from, Type* to, size_t count, std::false_type);
+
+    // move from[permutation[i]] to uninitialized to[i]
+    template<class Type>
+    void gather(
+        Type* from, Type* to, const std::uint32_t* permutation, size_t count
+    );
+
+    // stable, order[i] is the index of the i-th smallest key
+    template<class Key>
+    void radix_sort(const Key* keys, size_t size, std::uint32_t* order);
+    template<class Key, class Compare>
+    void comparison_sort(
+        const Key* keys, size_t size, Compare& compare, std::uint32_t* order
+    );
+
+    template<class Key, class Compare>
+    struct use_radix_sort : std::integral_constant<bool,
+        std::is_integral<Key>::value && !std::is_same<Key, bool>::value && (
+            std::is_same<Compare, std::less<>>::value ||
+            std::is_same<Compare, std::less<Key>>::value
+        )
+    > {};
+
+    template<class Key, class Compare>
+    void sort(
+        const Key* keys, size_t size, Compare&, std::uint32_t* order,
+        std::true_type
+    );
+    template<class Key, class Compare>
+    void sort(
+        const Key* keys, size_t size, Compare& compare, std::uint32_t* order,
+        std::false_type
+    );
+
+    template<class Type>
+    void destroy(Type* first, Type* last, std::true_type);
+    template<class Type>
+    void destroy(Type* first, Type* last, std::false_type);
 }
 
+
 template<class... Types>
-void arrays<Types...>::iterator::operator++() {
-    map(data, detail::incrementer());
+arrays_reference<Types...>::arrays_reference(Types&... elements) :
+    std::tuple<Types&...>(elements...) {}
+
+template<class... Types>
+const arrays_reference<Types...>& arrays_reference<Types...>::operator=(
+    const arrays_reference& other
+) const {
+    copy_from(other, std::index_sequence_for<Types...>());
+    return *this;
 }
 
 template<class... Types>
-void arrays<Types...>::iterator::operator--() {
-    map(data, detail::decrementer());
+const arrays_reference<Types...>& arrays_reference<Types...>::operator=(
+    arrays_reference&& other
+) const {
+    // moving a row onto itself would leave it moved from
+    if (&std::get<0>(*this) != &std::get<0>(other)) {
+        take_from(other, std::index_sequence_for<Types...>());
+    }
+    return *this;
 }
 
 template<class... Types>
-typename arrays<Types...>::iterator
-arrays<Types...>::iterator::operator+(std::ptrdiff_t value) {
-    return iterator(map(data, detail::adder(value)));
+const arrays_reference<Types...>& arrays_reference<Types...>::operator=(
+    const value_type& value
+) const {
+    copy_from(value, std::index_sequence_for<Types...>());
+    return *this;
 }
 
 template<class... Types>
-typename arrays<Types...>::iterator
-arrays<Types...>::iterator::operator-(std::ptrdiff_t value) {
-    return iterator(map(data, detail::adder(-value)));
+const arrays_reference<Types...>& arrays_reference<Types...>::operator=(
+    value_type&& value
+) const {
+    move_from(value, std::index_sequence_for<Types...>());
+    return *this;
 }
 
 template<class... Types>
-std::ptrdiff_t arrays<Types...>::iterator::operator-(const iterator& rhs) {
-    return std::get<0>(data) - std::get<0>(rhs.data);
+arrays_reference<Types...>::operator value_type() const & {
+    return copy(std::index_sequence_for<Types...>());
 }
 
 template<class... Types>
-bool arrays<Types...>::iterator::operator==(
-    const arrays<Types...>::iterator& rhs
+arrays_reference<Types...>::operator value_type() && {
+    return take(std::index_sequence_for<Types...>());
+}
+
+template<class... Types> template<class Tuple, size_t... I>
+void arrays_reference<Types...>::copy_from(
+    const Tuple& other, std::index_sequence<I...>
 ) const {
-    return std::get<0>(data) == std::get<0>(rhs.data);
+    using expand = int[];
+    (void)expand{0, (std::get<I>(*this) = std::get<I>(other), 0)...};
 }
 
-template<class... Types>
-bool arrays<Types...>::iterator::operator!=(
-    const arrays<Types...>::iterator& rhs
+template<class... Types> template<class Tuple, size_t... I>
+void arrays_reference<Types...>::move_from(
+    Tuple& other, std::index_sequence<I...>
 ) const {
-    return std::get<0>(data) != std::get<0>(rhs.data);
+    using expand = int[];
+    (void)expand{0, (
+        std::get<I>(*this) = std::move(std::get<I>(other)), 0
+    )...};
 }
 
-template<class... Types> template<class Type>
-span<Type> arrays<Types...>::get() {
-    return span<Type>(std::get<unique_span<Type>>(data));
+template<class... Types> template<size_t... I>
+void arrays_reference<Types...>::take_from(
+    const arrays_reference& other, std::index_sequence<I...>
+) const {
+    using expand = int[];
+    (void)expand{0, (
+        std::get<I>(*this) = detail::copy_or_move(std::get<I>(other)), 0
+    )...};
 }
 
-template<class... Types> template<int N>
-typename std::tuple_element<N, std::tuple<Types...>>::type
-arrays<Types...>::get() {
+template<class... Types> template<size_t... I>
+void arrays_reference<Types...>::swap_elements(
+    arrays_reference& other, std::index_sequence<I...>
+) {
+    using std::swap;
+    using expand = int[];
+    (void)expand{0, (swap(std::get<I>(*this), std::get<I>(other)), 0)...};
+}
+
+template<class... Types> template<size_t... I>
+typename arrays_reference<Types...>::value_type
+arrays_reference<Types...>::copy(std::index_sequence<I...>) const {
+    return value_type(std::get<I>(*this)...);
+}
+
+template<class... Types> template<size_t... I>
+typename arrays_reference<Types...>::value_type
+arrays_reference<Types...>::take(std::index_sequence<I...>) {
+    return value_type(detail::copy_or_move(std::get<I>(*this))...);
+}
+
+template<std::size_t Alignment, class... Types>
+aligned_arrays<Alignment, Types...>::iterator::iterator() :
+    columns(static_cast<Types*>(nullptr)...), row(0) {}
+
+template<std::size_t Alignment, class... Types>
+aligned_arrays<Alignment, Types...>::iterator::iterator(
+    const std::tuple<Types*...>& columns, size_t row
+) :
+    columns(columns), row(row) {}
+
+template<std::size_t Alignment, class... Types>
+typename aligned_arrays<Alignment, Types...>::reference
+aligned_arrays<Alignment, Types...>::iterator::operator*() const {
+    return dereference(row, std::index_sequence_for<Types...>());
+}
+
+template<std::size_t Alignment, class... Types>
+typename aligned_arrays<Alignment, Types...>::reference
+aligned_arrays<Alignment, Types...>::iterator::operator[](
+    std::ptrdiff_t n
+) const {
+    return dereference(row + n, std::index_sequence_for<Types...>());
+}
+
+template<std::size_t Alignment, class... Types> template<size_t... I>
+typename aligned_arrays<Alignment, Types...>::reference
+aligned_arrays<Alignment, Types...>::iterator::dereference(
+    size_t row, std::index_sequence<I...>
+) const {
+    return reference(std::get<I>(columns)[row]...);
+}
+
+template<std::size_t Alignment, class... Types>
+typename aligned_arrays<Alignment, Types...>::iterator&
+aligned_arrays<Alignment, Types...>::iterator::operator++() {
+    row++;
+    return *this;
+}
+
+template<std::size_t Alignment, class... Types>
+typename aligned_arrays<Alignment, Types...>::iterator
+aligned_arrays<Alignment, Types...>::iterator::operator++(int) {
+    iterator old = *this;
+    row++;
+    return old;
+}
+
+template<std::size_t Alignment, class... Types>
+typename aligned_arrays<Alignment, Types...>::iterator&
+aligned_arrays<Alignment, Types...>::iterator::operator--() {
+    row--;
+    return *this;
+}
+
+template<std::size_t Alignment, class... Types>
+typename aligned_arrays<Alignment, Types...>::iterator
+aligned_arrays<Alignment, Types...>::iterator::operator--(int) {
+    iterator old = *this;
+    row--;
+    return old;
+}
+
+template<std::size_t Alignment, class... Types>
+typename aligned_arrays<Alignment, Types...>::iterator&
+aligned_arrays<Alignment, Types...>::iterator::operator+=(std::ptrdiff_t n) {
+    row += n;
+    return *this;
+}
+
+template<std::size_t Alignment, class... Types>
+typename aligned_arrays<Alignment, Types...>::iterator&
+aligned_arrays<Alignment, Types...>::iterator::operator-=(std::ptrdiff_t n) {
+    row -= n;
+    return *this;
+}
+
+template<std::size_t Alignment, class... Types>
+typename aligned_arrays<Alignment, Types...>::iterator
+aligned_arrays<Alignment, Types...>::iterator::operator+(
+    std::ptrdiff_t n
+) const {
+    return iterator(columns, row + n);
+}
+
+template<std::size_t Alignment, class... Types>
+typename aligned_arrays<Alignment, Types...>::iterator
+aligned_arrays<Alignment, Types...>::iterator::operator-(
+    std::ptrdiff_t n
+) const {
+    return iterator(columns, row - n);
+}
+
+template<std::size_t Alignment, class... Types>
+std::ptrdiff_t aligned_arrays<Alignment, Types...>::iterator::operator-(
+    const iterator& rhs
+) const {
+    return std::ptrdiff_t(row) - std::ptrdiff_t(rhs.row);
+}
+
+template<std::size_t Alignment, class... Types>
+bool aligned_arrays<Alignment, Types...>::iterator::operator==(
+    const iterator& rhs
+) const {
+    return row == rhs.row;
+}
+
+template<std::size_t Alignment, class... Types>
+bool aligned_arrays<Alignment, Types...>::iterator::operator!=(
+    const iterator& rhs
+) const {
+    return row != rhs.row;
+}
+
+template<std::size_t Alignment, class... Types>
+bool aligned_arrays<Alignment, Types...>::iterator::operator<(
+    const iterator& rhs
+) const {
+    return row < rhs.row;
+}
+
+template<std::size_t Alignment, class... Types>
+bool aligned_arrays<Alignment, Types...>::iterator::operator>(
+    const iterator& rhs
+) const {
+    return row > rhs.row;
+}
+
+template<std::size_t Alignment, class... Types>
+bool aligned_arrays<Alignment, Types...>::iterator::operator<=(
+    const iterator& rhs
+) const {
+    return row <= rhs.row;
+}
+
+template<std::size_t Alignment, class... Types>
+bool aligned_arrays<Alignment, Types...>::iterator::operator>=(
+    const iterator& rhs
+) const {
+    return row >= rhs.row;
+}
+
+template<std::size_t Alignment, class... Types>
+aligned_arrays<Alignment, Types...>::aligned_arrays() :
+    memory(nullptr),
+    columns(static_cast<Types*>(nullptr)...),
+    rows(0),
+    reserved(0) {}
+
+template<std::size_t Alignment, class... Types>
+aligned_arrays<Alignment, Types...>::aligned_arrays(
+    aligned_arrays&& other
+) noexcept :
+    memory(other.memory),
+    columns(other.columns),
+    rows(other.rows),
+    reserved(other.reserved)
+{
+    other.memory = nullptr;
+    other.columns = std::tuple<Types*...>(static_cast<Types*>(nullptr)...);
+    other.rows = 0;
+    other.reserved = 0;
+}
+
+template<std::size_t Alignment, class... Types>
+aligned_arrays<Alignment, Types...>::~aligned_arrays() {
+    destroy(0, rows, indices());
+    ::operator delete(memory);
+}
+
+template<std::size_t Alignment, class... Types>
+aligned_arrays<Alignment, Types...>&
+aligned_arrays<Alignment, Types...>::operator=(
+    aligned_arrays&& other
+) noexcept {
+    if (this != &other) {
+        destroy(0, rows, indices());
+        ::operator delete(memory);
+
+        memory = other.memory;
+        columns = other.columns;
+        rows = other.rows;
+        reserved = other.reserved;
+
+        other.memory = nullptr;
+        other.columns =
+            std::tuple<Types*...>(static_cast<Types*>(nullptr)...);
+        other.rows = 0;
+        other.reserved = 0;
+    }
+    return *this;
+}
+
+template<std::size_t Alignment, class... Types> template<class Type>
+span<Type> aligned_arrays<Alignment, Types...>::get() {
+    Type* begin = std::get<Type*>(columns);
+    return span<Type>(begin, begin + rows);
+}
+
+template<std::size_t Alignment, class... Types> template<int N>
+span<typename std::tuple_element<N, std::tuple<Types...>>::type>
+aligned_arrays<Alignment, Types...>::get() {
+    auto begin = std::get<N>(columns);
     return span<typename std::tuple_element<N, std::tuple<Types...>>::type>(
-        std::get<N>(data)
+        begin, begin + rows
+    );
+}
+
+template<std::size_t Alignment, class... Types> template<class Type>
+span<const Type> aligned_arrays<Alignment, Types...>::get() const {
+    const Type* begin = std::get<Type*>(columns);
+    return span<const Type>(begin, begin + rows);
+}
+
+template<std::size_t Alignment, class... Types> template<int N>
+span<const typename std::tuple_element<N, std::tuple<Types...>>::type>
+aligned_arrays<Alignment, Types...>::get() const {
+    typedef typename std::tuple_element<N, std::tuple<Types...>>::type type;
+    const type* begin = std::get<N>(columns);
+    return span<const type>(begin, begin + rows);
+}
+
+template<std::size_t Alignment, class... Types> template<int... N>
+arrays_view<typename std::tuple_element<N, std::tuple<Types...>>::type...>
+aligned_arrays<Alignment, Types...>::view() {
+    return arrays_view<
+        typename std::tuple_element<N, std::tuple<Types...>>::type...
+    >(std::make_tuple(std::get<N>(columns)...), rows);
+}
+
+template<std::size_t Alignment, class... Types> template<class... Selected>
+arrays_view<Selected...> aligned_arrays<Alignment, Types...>::view() {
+    return arrays_view<Selected...>(
+        std::make_tuple(
+            std::get<detail::type_index<Selected, Types...>()>(columns)...
+        ),
+        rows
+    );
+}
+
+template<std::size_t Alignment, class... Types>
+size_t aligned_arrays<Alignment, Types...>::size() const {
+    return rows;
+}
+
+template<std::size_t Alignment, class... Types>
+size_t aligned_arrays<Alignment, Types...>::capacity() const {
+    return reserved;
+}
+
+template<std::size_t Alignment, class... Types>
+typename aligned_arrays<Alignment, Types...>::iterator
+aligned_arrays<Alignment, Types...>::begin() const {
+    return iterator(columns, 0);
+}
+
+template<std::size_t Alignment, class... Types>
+typename aligned_arrays<Alignment, Types...>::iterator
+aligned_arrays<Alignment, Types...>::end() const {
+    return iterator(columns, rows);
+}
+
+template<std::size_t Alignment, class... Types>
+typename aligned_arrays<Alignment, Types...>::iterator
+aligned_arrays<Alignment, Types...>::insert(std::tuple<Types&&...> value) {
+    return insert(value, indices());
+}
+
+template<std::size_t Alignment, class... Types> template<size_t... I>
+typename aligned_arrays<Alignment, Types...>::iterator
+aligned_arrays<Alignment, Types...>::insert(
+    std::tuple<Types&&...>& value, std::index_sequence<I...>
+) {
+    return emplace_back(std::forward<Types>(std::get<I>(value))...);
+}
+
+template<std::size_t Alignment, class... Types> template<class... Args>
+typename aligned_arrays<Alignment, Types...>::iterator
+aligned_arrays<Alignment, Types...>::emplace_back(Args&&... args) {
+    static_assert(
+        sizeof...(Args) == column_count, "one argument per column"
+    );
+
+    if (rows == reserved) {
+        // like std::vector, construct the row before moving the others,
+        // the arguments may refer to them
+        size_t capacity = padded(reserved == 0 ? 4 : reserved * 2);
+        std::tuple<Types*...> new_columns;
+        void* new_memory = allocate(capacity, new_columns);
+        try {
+            construct(new_columns, indices(), std::forward<Args>(args)...);
+        } catch (...) {
+            // the table is unchanged, only the new block has to go
+            ::operator delete(new_memory);
+            throw;
+        }
+        adopt(new_memory, new_columns, capacity);
+    } else {
+        construct(columns, indices(), std::forward<Args>(args)...);
+    }
+
+    return begin() + rows++;
+}
+
+template<std::size_t Alignment, class... Types>
+typename aligned_arrays<Alignment, Types...>::iterator
+aligned_arrays<Alignment, Types...>::erase(iterator i) {
+    size_t index = i - begin();
+    if (index != rows - 1) {
+        move_row(rows - 1, index, indices());
+    }
+    destroy(rows - 1, rows, indices());
+    rows--;
+    return i;
+}
+
+template<std::size_t Alignment, class... Types>
+void aligned_arrays<Alignment, Types...>::reserve(size_t capacity) {
+    if (capacity > reserved) {
+        reallocate(capacity);
+    }
+}
+
+template<std::size_t Alignment, class... Types>
+void aligned_arrays<Alignment, Types...>::shrink_to_fit() {
+    if (padded(rows) < reserved) {
+        reallocate(rows);
+    }
+}
+
+template<std::size_t Alignment, class... Types>
+size_t aligned_arrays<Alignment, Types...>::padded(size_t capacity) {
+    return detail::align_up(
+        capacity, detail::padding_rows<Alignment, Types...>()
+    );
+}
+
+template<std::size_t Alignment, class... Types>
+void aligned_arrays<Alignment, Types...>::reallocate(size_t capacity) {
+    capacity = padded(capacity);
+
+    std::tuple<Types*...> new_columns;
+    void* new_memory = allocate(capacity, new_columns);
+    adopt(new_memory, new_columns, capacity);
+}
+
+template<std::size_t Alignment, class... Types>
+void aligned_arrays<Alignment, Types...>::adopt(
+    void* new_memory, const std::tuple<Types*...>& new_columns,
+    size_t capacity
+) {
+    relocate(new_columns, indices());
+    ::operator delete(memory);
+
+    memory = new_memory;
+    columns = new_columns;
+    reserved = capacity;
+}
+
+template<std::size_t Alignment, class... Types>
+void* aligned_arrays<Alignment, Types...>::allocate(
+    size_t capacity, std::tuple<Types*...>& columns
+) {
+    size_t offsets[column_count];
+    size_t bytes = layout(capacity, offsets);
+
+    void* memory = nullptr;
+    char* base = nullptr;
+    if (capacity > 0) {
+        memory = ::operator new(bytes + extra_bytes);
+        base = static_cast<char*>(memory);
+        base += detail::align_up(
+            reinterpret_cast<std::uintptr_t>(base), base_alignment
+        ) - reinterpret_cast<std::uintptr_t>(base);
+    }
+
+    columns = place(base, offsets, indices());
+    return memory;
+}
+
+template<std::size_t Alignment, class... Types>
+template<int N, class Compare>
+void aligned_arrays<Alignment, Types...>::sort_by(Compare compare) {
+    typedef typename std::tuple_element<N, std::tuple<Types...>>::type key;
+    assert(rows <= UINT32_MAX);
+
+    std::vector<std::uint32_t> order(rows);
+    detail::sort(
+        std::get<N>(columns), rows, compare, order.data(),
+        detail::use_radix_sort<key, Compare>()
+    );
+    apply_permutation(
+        span<const std::uint32_t>(order.data(), order.data() + rows)
+    );
+}
+
+template<std::size_t Alignment, class... Types>
+void aligned_arrays<Alignment, Types...>::apply_permutation(
+    span<const std::uint32_t> permutation
+) {
+    assert(size_t(permutation.end() - permutation.begin()) == rows);
+
+    // column by column into new storage, so reads are the only
+    // random accesses and every write is sequential
+    std::tuple<Types*...> new_columns;
+    void* new_memory = allocate(reserved, new_columns);
+
+    gather(new_columns, permutation.begin(), indices());
+    destroy(0, rows, indices());
+    ::operator delete(memory);
+
+    memory = new_memory;
+    columns = new_columns;
+}
+
+template<std::size_t Alignment, class... Types>
+size_t aligned_arrays<Alignment, Types...>::layout(
+    size_t capacity, size_t (&offsets)[column_count]
+) {
+    const size_t sizes[] = {sizeof(Types)...};
+    const size_t alignments[] = {
+        alignof(Types) > Alignment ? alignof(Types) : Alignment...
+    };
+
+    size_t bytes = 0;
+    for (size_t i = 0; i < column_count; i++) {
+        bytes = detail::align_up(bytes, alignments[i]);
+        offsets[i] = bytes;
+        bytes += capacity * sizes[i];
+    }
+    return bytes;
+}
+
+template<std::size_t Alignment, class... Types> template<size_t... I>
+std::tuple<Types*...> aligned_arrays<Alignment, Types...>::place(
+    char* memory, const size_t (&offsets)[column_count],
+    std::index_sequence<I...>
+) {
+    if (memory == nullptr) {
+        return std::tuple<Types*...>(static_cast<Types*>(nullptr)...);
+    }
+    return std::tuple<Types*...>(
+        reinterpret_cast<Types*>(memory + offsets[I])...
     );
 }
 
+template<std::size_t Alignment, class... Types> template<size_t... I>
+void aligned_arrays<Alignment, Types...>::relocate(
+    const std::tuple<Types*...>& to, std::index_sequence<I...>
+) {
+    using expand = int[];
+    (void)expand{0, (detail::relocate(
+        std::get<I>(columns), std::get<I>(to), rows,
+        std::is_trivially_copyable<Types>()
+    ), 0)...};
+}
+
+template<std::size_t Alignment, class... Types> template<size_t... I>
+void aligned_arrays<Alignment, Types...>::gather(
+    const std::tuple<Types*...>& to, const std::uint32_t* permutation,
+    std::index_sequence<I...>
+) {
+    using expand = int[];
+    (void)expand{0, (detail::gather(
+        std::get<I>(columns), std::get<I>(to), permutation, rows
+    ), 0)...};
+}
+
+template<std::size_t Alignment, class... Types>
+template<size_t... I, class... Args>
+void aligned_arrays<Alignment, Types...>::construct(
+    const std::tuple<Types*...>& to, std::index_sequence<I...>,
+    Args&&... args
+) {
+    using expand = int[];
+    (void)expand{0, (
+        new (std::get<I>(to) + rows) Types(std::forward<Args>(args)), 0
+    )...};
+}
+
+template<std::size_t Alignment, class... Types> template<size_t... I>
+void aligned_arrays<Alignment, Types...>::move_row(
+    size_t from, size_t to, std::index_sequence<I...>
+) {
+    using expand = int[];
+    (void)expand{0, (
+        std::get<I>(columns)[to] = std::move(std::get<I>(columns)[from]), 0
+    )...};
+}
+
+template<std::size_t Alignment, class... Types> template<size_t... I>
+void aligned_arrays<Alignment, Types...>::destroy(
+    size_t first, size_t last, std::index_sequence<I...>
+) {
+    using expand = int[];
+    (void)expand{0, (detail::destroy(
+        std::get<I>(columns) + first, std::get<I>(columns) + last,
+        std::is_trivially_destructible<Types>()
+    ), 0)...};
+}
+
 template<class... Types>
-size_t arrays<Types...>::size() const {
-    return end() - begin();
+arrays_view<Types...>::iterator::iterator() :
+    columns(static_cast<Types*>(nullptr)...), row(0) {}
+
+template<class... Types>
+arrays_view<Types...>::iterator::iterator(
+    const std::tuple<Types*...>& columns, size_t row
+) :
+    columns(columns), row(row) {}
+
+template<class... Types>
+std::tuple<Types&...> arrays_view<Types...>::iterator::operator*() const {
+    return dereference(std::index_sequence_for<Types...>());
+}
+
+template<class... Types> template<size_t... I>
+std::tuple<Types&...> arrays_view<Types...>::iterator::dereference(
+    std::index_sequence<I...>
+) const {
+    return std::tuple<Types&...>(std::get<I>(columns)[row]...);
 }
 
 template<class... Types>
-size_t arrays<Types...>::capacity() const {
-    return std::get<0>(data).end() - std::get<0>(data).begin();
+typename arrays_view<Types...>::iterator&
+arrays_view<Types...>::iterator::operator++() {
+    row++;
+    return *this;
 }
 
 template<class... Types>
-typename arrays<Types...>::iterator arrays<Types...>::begin() const {
-    return iterator(map(data, detail::unique_span_beginner()));
+typename arrays_view<Types...>::iterator
+arrays_view<Types...>::iterator::operator++(int) {
+    iterator old = *this;
+    row++;
+    return old;
 }
 
 template<class... Types>
-typename arrays<Types...>::iterator arrays<Types...>::end() const {
-    return end_iterator;
+bool arrays_view<Types...>::iterator::operator==(const iterator& rhs) const {
+    return row == rhs.row;
 }
 
 template<class... Types>
-typename arrays<Types...>::iterator
-arrays<Types...>::insert(std::tuple<Types&&...> value) {
-    if (size() == capacity()) {
-        // resize
-        // TODO: allocate storage without initializing elements
-        std::tuple<unique_span<Types>...> new_data;
-        if (capacity() == 0) {
-            new_data = std::make_tuple(unique_span<Types>(4)...);
-        } else {
-            new_data = std::make_tuple(unique_span<Types>(capacity() * 2)...);
-        }
+bool arrays_view<Types...>::iterator::operator!=(const iterator& rhs) const {
+    return row != rhs.row;
+}
 
-        end_iterator = std::move(
-            begin(), end(),
-            iterator(map(new_data, detail::unique_span_beginner()))
-        );
+template<class... Types>
+arrays_view<Types...>::arrays_view(
+    const std::tuple<Types*...>& columns, size_t rows
+) :
+    columns(columns), rows(rows) {}
 
-        data = std::move(new_data);
-    }
+template<class... Types> template<int N>
+span<typename std::tuple_element<N, std::tuple<Types...>>::type>
+arrays_view<Types...>::get() const {
+    auto begin = std::get<N>(columns);
+    return span<typename std::tuple_element<N, std::tuple<Types...>>::type>(
+        begin, begin + rows
+    );
+}
 
-    *end_iterator = std::move(value);
-    iterator i = end_iterator;
-    ++end_iterator;
-    return i;
+template<class... Types>
+size_t arrays_view<Types...>::size() const {
+    return rows;
 }
 
 template<class... Types>
-typename arrays<Types...>::iterator
-arrays<Types...>::erase(arrays<Types...>::iterator i) {
-    --end_iterator;
-    *i = std::move(*end_iterator);
-    return i;
+typename arrays_view<Types...>::iterator arrays_view<Types...>::begin() const {
+    return iterator(columns, 0);
 }
 
-template<class Type>
-Type& detail::incrementer::operator()(Type& i) {
-    i++;
-    return i;
+template<class... Types>
+typename arrays_view<Types...>::iterator arrays_view<Types...>::end() const {
+    return iterator(columns, rows);
 }
 
 template<class Type>
-Type& detail::decrementer::operator()(Type& i) {
-    i--;
-    return i;
+std::conditional_t<
+    std::is_copy_constructible<Type>::value, const Type&, Type&&
+>
+detail::copy_or_move(Type& value) {
+    return static_cast<std::conditional_t<
+        std::is_copy_constructible<Type>::value, const Type&, Type&&
+    >>(value);
 }
 
-detail::adder::adder(std::ptrdiff_t diff) : diff(diff) {}
-
 template<class Type>
-Type detail::adder::operator()(const Type& i) {
-    return i + diff;
+void detail::relocate(Type* from, Type* to, size_t count, std::true_type) {
+    if (count > 0) {
+        std::memcpy(
+            static_cast<void*>(to), static_cast<const void*>(from),
+            count * sizeof(Type)
+        );
+    }
 }
 
 template<class Type>
-Type* detail::unique_span_beginner::operator()(const unique_span<Type>& s) {
-    return s.begin();
+void detail::relocate(Type* from, Type* to, size_t count, std::false_type) {
+    for (size_t i = 0; i < count; i++) {
+        new (to + i) Type(std::move(from[i]));
+        from[i].~Type();
+    }
 }
 
 template<class Type>
-Type* detail::unique_span_ender::operator()(const unique_span<Type>& s) {
-    return s.end();
+void detail::gather(
+    Type* from, Type* to, const std::uint32_t* permutation, size_t count
+) {
+    for (size_t i = 0; i < count; i++) {
+        new (to + i) Type(std::move(from[permutation[i]]));
+    }
+}
+
+template<class Key>
+void detail::radix_sort(const Key* keys, size_t size, std::uint32_t* order) {
+    // least significant byte first, signed keys with the sign bit
+    // flipped so they order like unsigned ones
+    typedef std::make_unsigned_t<Key> bits;
+    const bits flip = std::is_signed<Key>::value ?
+        bits(bits(1) << (sizeof(Key) * 8 - 1)) : bits(0);
+
+    std::vector<std::pair<bits, std::uint32_t>> items(size);
+    std::vector<std::pair<bits, std::uint32_t>> sorted(size);
+    for (size_t i = 0; i < size; i++) {
+        items[i] = {bits(bits(keys[i]) ^ flip), std::uint32_t(i)};
+    }
+
+    for (size_t shift = 0; shift < sizeof(Key) * 8; shift += 8) {
+        size_t counts[256] = {};
+        for (auto& item : items) {
+            counts[item.first >> shift & 0xff]++;
+        }
+
+        // every key has the same byte here, nothing would move
+        if (size == 0 || counts[items[0].first >> shift & 0xff] == size) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (size_t& count : counts) {
+            size_t c = count;
+            count = offset;
+            offset += c;
+        }
+        for (auto& item : items) {
+            sorted[counts[item.first >> shift & 0xff]++] = item;
+        }
+        items.swap(sorted);
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        order[i] = items[i].second;
+    }
+}
+
+template<class Key, class Compare>
+void detail::comparison_sort(
+    const Key* keys, size_t size, Compare& compare, std::uint32_t* order
+) {
+    std::iota(order, order + size, std::uint32_t(0));
+    std::stable_sort(
+        order, order + size, [&](std::uint32_t a, std::uint32_t b) {
+            return compare(keys[a], keys[b]);
+        }
+    );
+}
+
+template<class Key, class Compare>
+void detail::sort(
+    const Key* keys, size_t size, Compare&, std::uint32_t* order,
+    std::true_type
+) {
+    radix_sort(keys, size, order);
+}
+
+template<class Key, class Compare>
+void detail::sort(
+    const Key* keys, size_t size, Compare& compare, std::uint32_t* order,
+    std::false_type
+) {
+    comparison_sort(keys, size, compare, order);
 }
 
 template<class Type>
-Type&& detail::pointer_referencer::operator()(Type* p) {
+void detail::destroy(Type*, Type*, std::true_type) {}
 
-    return std::move(*p);
+template<class Type>
+void detail::destroy(Type* first, Type* last, std::false_type) {
+    for (; first != last; ++first) {
+        first->~Type();
+    }
 }
 
 }
@@ -0,0 +1,556 @@
+#ifndef ARRAYS_TILED_H
+#define ARRAYS_TILED_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "arrays.h"
+#include "span.h"
+
+namespace fast {
+
+template<std::size_t N, class... Types>
+struct arrays_tiled {
+    /* arrays in tiles of N rows. A tile holds a run of N
+     * elements of every column, so a row is within one tile
+     * and a column is contiguous within a tile. Runs start on
+     * simd_alignment, N * sizeof(Type) being a multiple of it
+     * avoids padding between them.
+     */
+
+    static_assert(N > 0, "tiles need at least one row");
+    static_assert(sizeof...(Types) > 0, "arrays needs at least one column");
+
+    // a row, assignable and swappable, see arrays_reference
+    typedef arrays_reference<Types...> reference;
+
+    struct iterator {
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef std::tuple<Types...> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef void pointer;
+        typedef typename arrays_tiled::reference reference;
+
+        iterator();
+
+        reference operator*() const;
+        reference operator[](std::ptrdiff_t n) const;
+
+        iterator& operator++();
+        iterator operator++(int);
+        iterator& operator--();
+        iterator operator--(int);
+        iterator& operator+=(std::ptrdiff_t n);
+        iterator& operator-=(std::ptrdiff_t n);
+        iterator operator+(std::ptrdiff_t n) const;
+        iterator operator-(std::ptrdiff_t n) const;
+        std::ptrdiff_t operator-(const iterator& rhs) const;
+
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+        bool operator<(const iterator& rhs) const;
+        bool operator>(const iterator& rhs) const;
+        bool operator<=(const iterator& rhs) const;
+        bool operator>=(const iterator& rhs) const;
+
+        friend iterator operator+(std::ptrdiff_t n, const iterator& i) {
+            return i + n;
+        }
+
+    private:
+        friend struct arrays_tiled;
+
+        iterator(char* tiles, std::size_t row);
+
+        template<std::size_t... I>
+        reference dereference(
+            std::size_t row, std::index_sequence<I...>
+        ) const;
+
+        char* tiles;
+        std::size_t row;
+    };
+
+    static constexpr std::size_t tile_rows = N;
+
+    arrays_tiled();
+    arrays_tiled(arrays_tiled&& other) noexcept;
+    ~arrays_tiled();
+
+    arrays_tiled(const arrays_tiled&) = delete;
+
+    arrays_tiled& operator=(arrays_tiled&& other) noexcept;
+    arrays_tiled& operator=(const arrays_tiled&) = delete;
+
+    // the elements of one column in one tile
+    template<class Type>
+    span<Type> get(std::size_t tile);
+
+    template<int I>
+    span<typename std::tuple_element<I, std::tuple<Types...>>::type>
+    get(std::size_t tile);
+
+    // tiles with at least one row
+    std::size_t tiles() const;
+    std::size_t size() const;
+    std::size_t capacity() const;
+
+    iterator begin() const;
+    iterator end() const;
+
+    iterator insert(std::tuple<Types&&...> value);
+    // construct a row at the end, one argument per column
+    template<class... Args>
+    iterator emplace_back(Args&&... args);
+    // moves the last row into i
+    iterator erase(iterator i);
+
+    // make room for capacity rows, rounded up to whole tiles
+    void reserve(std::size_t capacity);
+
+private:
+    static constexpr std::size_t column_count = sizeof...(Types);
+    static constexpr std::size_t tile_alignment =
+        simd_alignment > detail::max_alignment<Types...>() ?
+            simd_alignment : detail::max_alignment<Types...>();
+    typedef std::index_sequence_for<Types...> indices;
+
+    // start of a column in a tile, column_count gives the tile size
+    static constexpr std::size_t offset(std::size_t column);
+
+    template<std::size_t I>
+    static typename std::tuple_element<I, std::tuple<Types...>>::type*
+    element(char* tiles, std::size_t row);
+
+    // rows used in a tile
+    std::size_t used(std::size_t tile) const;
+
+    template<std::size_t... I>
+    iterator insert(std::tuple<Types&&...>& value, std::index_sequence<I...>);
+
+    void reallocate(std::size_t tiles);
+    // storage for tiles, base is set to the first one
+    static void* allocate(std::size_t tiles, char*& base);
+    // move the rows to new_base and free the old storage
+    void adopt(void* new_memory, char* new_base, std::size_t tiles);
+
+    template<std::size_t... I>
+    void relocate(char* to, std::index_sequence<I...>);
+    // the row after the last one, in base or in new tiles
+    template<std::size_t... I, class... Args>
+    void construct(
+        char* tiles, std::index_sequence<I...>, Args&&... args
+    );
+    template<std::size_t... I>
+    void move_row(
+        std::size_t from, std::size_t to, std::index_sequence<I...>
+    );
+    template<std::size_t... I>
+    void destroy(
+        std::size_t first, std::size_t last, std::index_sequence<I...>
+    );
+
+    // as returned by operator new, the tiles may start later
+    void* memory;
+    char* base;
+    std::size_t rows;
+    std::size_t reserved;
+};
+
+template<std::size_t N, class... Types>
+arrays_tiled<N, Types...>::iterator::iterator() :
+    tiles(nullptr), row(0) {}
+
+template<std::size_t N, class... Types>
+arrays_tiled<N, Types...>::iterator::iterator(char* tiles, std::size_t row) :
+    tiles(tiles), row(row) {}
+
+template<std::size_t N, class... Types>
+typename arrays_tiled<N, Types...>::reference
+arrays_tiled<N, Types...>::iterator::operator*() const {
+    return dereference(row, indices());
+}
+
+template<std::size_t N, class... Types>
+typename arrays_tiled<N, Types...>::reference
+arrays_tiled<N, Types...>::iterator::operator[](std::ptrdiff_t n) const {
+    return dereference(row + n, indices());
+}
+
+template<std::size_t N, class... Types> template<std::size_t... I>
+typename arrays_tiled<N, Types...>::reference
+arrays_tiled<N, Types...>::iterator::dereference(
+    std::size_t row, std::index_sequence<I...>
+) const {
+    return reference(*element<I>(tiles, row)...);
+}
+
+template<std::size_t N, class... Types>
+typename arrays_tiled<N, Types...>::iterator&
+arrays_tiled<N, Types...>::iterator::operator++() {
+    row++;
+    return *this;
+}
+
+template<std::size_t N, class... Types>
+typename arrays_tiled<N, Types...>::iterator
+arrays_tiled<N, Types...>::iterator::operator++(int) {
+    iterator old = *this;
+    row++;
+    return old;
+}
+
+template<std::size_t N, class... Types>
+typename arrays_tiled<N, Types...>::iterator&
+arrays_tiled<N, Types...>::iterator::operator--() {
+    row--;
+    return *this;
+}
+
+template<std::size_t N, class... Types>
+typename arrays_tiled<N, Types...>::iterator
+arrays_tiled<N, Types...>::iterator::operator--(int) {
+    iterator old = *this;
+    row--;
+    return old;
+}
+
+template<std::size_t N, class... Types>
+typename arrays_tiled<N, Types...>::iterator&
+arrays_tiled<N, Types...>::iterator::operator+=(std::ptrdiff_t n) {
+    row += n;
+    return *this;
+}
+
+template<std::size_t N, class... Types>
+typename arrays_tiled<N, Types...>::iterator&
+arrays_tiled<N, Types...>::iterator::operator-=(std::ptrdiff_t n) {
+    row -= n;
+    return *this;
+}
+
+template<std::size_t N, class... Types>
+typename arrays_tiled<N, Types...>::iterator
+arrays_tiled<N, Types...>::iterator::operator+(std::ptrdiff_t n) const {
+    return iterator(tiles, row + n);
+}
+
+template<std::size_t N, class... Types>
+typename arrays_tiled<N, Types...>::iterator
+arrays_tiled<N, Types...>::iterator::operator-(std::ptrdiff_t n) const {
+    return iterator(tiles, row - n);
+}
+
+template<std::size_t N, class... Types>
+std::ptrdiff_t arrays_tiled<N, Types...>::iterator::operator-(
+    const iterator& rhs
+) const {
+    return std::ptrdiff_t(row) - std::ptrdiff_t(rhs.row);
+}
+
+template<std::size_t N, class... Types>
+bool arrays_tiled<N, Types...>::iterator::operator==(
+    const iterator& rhs
+) const {
+    return row == rhs.row;
+}
+
+template<std::size_t N, class... Types>
+bool arrays_tiled<N, Types...>::iterator::operator!=(
+    const iterator& rhs
+) const {
+    return row != rhs.row;
+}
+
+template<std::size_t N, class... Types>
+bool arrays_tiled<N, Types...>::iterator::operator<(
+    const iterator& rhs
+) const {
+    return row < rhs.row;
+}
+
+template<std::size_t N, class... Types>
+bool arrays_tiled<N, Types...>::iterator::operator>(
+    const iterator& rhs
+) const {
+    return row > rhs.row;
+}
+
+template<std::size_t N, class... Types>
+bool arrays_tiled<N, Types...>::iterator::operator<=(
+    const iterator& rhs
+) const {
+    return row <= rhs.row;
+}
+
+template<std::size_t N, class... Types>
+bool arrays_tiled<N, Types...>::iterator::operator>=(
+    const iterator& rhs
+) const {
+    return row >= rhs.row;
+}
+
+template<std::size_t N, class... Types>
+arrays_tiled<N, Types...>::arrays_tiled() :
+    memory(nullptr), base(nullptr), rows(0), reserved(0) {}
+
+template<std::size_t N, class... Types>
+arrays_tiled<N, Types...>::arrays_tiled(arrays_tiled&& other) noexcept :
+    memory(other.memory),
+    base(other.base),
+    rows(other.rows),
+    reserved(other.reserved)
+{
+    other.memory = nullptr;
+    other.base = nullptr;
+    other.rows = 0;
+    other.reserved = 0;
+}
+
+template<std::size_t N, class... Types>
+arrays_tiled<N, Types...>::~arrays_tiled() {
+    destroy(0, rows, indices());
+    ::operator delete(memory);
+}
+
+template<std::size_t N, class... Types>
+arrays_tiled<N, Types...>& arrays_tiled<N, Types...>::operator=(
+    arrays_tiled&& other
+) noexcept {
+    if (this != &other) {
+        destroy(0, rows, indices());
+        ::operator delete(memory);
+
+        memory = other.memory;
+        base = other.base;
+        rows = other.rows;
+        reserved = other.reserved;
+
+        other.memory = nullptr;
+        other.base = nullptr;
+        other.rows = 0;
+        other.reserved = 0;
+    }
+    return *this;
+}
+
+template<std::size_t N, class... Types> template<class Type>
+span<Type> arrays_tiled<N, Types...>::get(std::size_t tile) {
+    Type* begin = element<detail::type_index<Type, Types...>()>(base, tile * N);
+    return span<Type>(begin, begin + used(tile));
+}
+
+template<std::size_t N, class... Types> template<int I>
+span<typename std::tuple_element<I, std::tuple<Types...>>::type>
+arrays_tiled<N, Types...>::get(std::size_t tile) {
+    auto begin = element<I>(base, tile * N);
+    return span<typename std::tuple_element<I, std::tuple<Types...>>::type>(
+        begin, begin + used(tile)
+    );
+}
+
+template<std::size_t N, class... Types>
+std::size_t arrays_tiled<N, Types...>::tiles() const {
+    return (rows + N - 1) / N;
+}
+
+template<std::size_t N, class... Types>
+std::size_t arrays_tiled<N, Types...>::size() const {
+    return rows;
+}
+
+template<std::size_t N, class... Types>
+std::size_t arrays_tiled<N, Types...>::capacity() const {
+    return reserved;
+}
+
+template<std::size_t N, class... Types>
+typename arrays_tiled<N, Types...>::iterator
+arrays_tiled<N, Types...>::begin() const {
+    return iterator(base, 0);
+}
+
+template<std::size_t N, class... Types>
+typename arrays_tiled<N, Types...>::iterator
+arrays_tiled<N, Types...>::end() const {
+    return iterator(base, rows);
+}
+
+template<std::size_t N, class... Types>
+typename arrays_tiled<N, Types...>::iterator
+arrays_tiled<N, Types...>::insert(std::tuple<Types&&...> value) {
+    return insert(value, indices());
+}
+
+template<std::size_t N, class... Types> template<std::size_t... I>
+typename arrays_tiled<N, Types...>::iterator
+arrays_tiled<N, Types...>::insert(
+    std::tuple<Types&&...>& value, std::index_sequence<I...>
+) {
+    return emplace_back(std::forward<Types>(std::get<I>(value))...);
+}
+
+template<std::size_t N, class... Types> template<class... Args>
+typename arrays_tiled<N, Types...>::iterator
+arrays_tiled<N, Types...>::emplace_back(Args&&... args) {
+    static_assert(
+        sizeof...(Args) == column_count, "one argument per column"
+    );
+
+    if (rows == reserved) {
+        // like arrays, construct the row before moving the others,
+        // the arguments may refer to them
+        std::size_t tiles = reserved == 0 ? 1 : 2 * reserved / N;
+        char* new_base;
+        void* new_memory = allocate(tiles, new_base);
+        try {
+            construct(new_base, indices(), std::forward<Args>(args)...);
+        } catch (...) {
+            ::operator delete(new_memory);
+            throw;
+        }
+        adopt(new_memory, new_base, tiles);
+    } else {
+        construct(base, indices(), std::forward<Args>(args)...);
+    }
+
+    return iterator(base, rows++);
+}
+
+template<std::size_t N, class... Types>
+typename arrays_tiled<N, Types...>::iterator
+arrays_tiled<N, Types...>::erase(iterator i) {
+    if (i.row != rows - 1) {
+        move_row(rows - 1, i.row, indices());
+    }
+    destroy(rows - 1, rows, indices());
+    rows--;
+    return i;
+}
+
+template<std::size_t N, class... Types>
+void arrays_tiled<N, Types...>::reserve(std::size_t capacity) {
+    if (capacity > reserved) {
+        reallocate((capacity + N - 1) / N);
+    }
+}
+
+template<std::size_t N, class... Types>
+constexpr std::size_t arrays_tiled<N, Types...>::offset(std::size_t column) {
+    const std::size_t sizes[] = {sizeof(Types)...};
+    const std::size_t alignments[] = {
+        alignof(Types) > simd_alignment ? alignof(Types) : simd_alignment...
+    };
+
+    std::size_t bytes = 0;
+    for (std::size_t i = 0; i < column; i++) {
+        bytes = detail::align_up(bytes, alignments[i]) + N * sizes[i];
+    }
+    return detail::align_up(
+        bytes, column < column_count ? alignments[column] : tile_alignment
+    );
+}
+
+template<std::size_t N, class... Types> template<std::size_t I>
+typename std::tuple_element<I, std::tuple<Types...>>::type*
+arrays_tiled<N, Types...>::element(char* tiles, std::size_t row) {
+    typedef typename std::tuple_element<I, std::tuple<Types...>>::type type;
+    constexpr std::size_t tile_bytes = offset(column_count);
+    constexpr std::size_t column = offset(I);
+    return reinterpret_cast<type*>(
+        tiles + row / N * tile_bytes + column
+    ) + row % N;
+}
+
+template<std::size_t N, class... Types>
+std::size_t arrays_tiled<N, Types...>::used(std::size_t tile) const {
+    std::size_t first = tile * N;
+    return rows - first < N ? rows - first : N;
+}
+
+template<std::size_t N, class... Types>
+void arrays_tiled<N, Types...>::reallocate(std::size_t tiles) {
+    char* new_base;
+    void* new_memory = allocate(tiles, new_base);
+    adopt(new_memory, new_base, tiles);
+}
+
+template<std::size_t N, class... Types>
+void* arrays_tiled<N, Types...>::allocate(std::size_t tiles, char*& base) {
+    constexpr std::size_t tile_bytes = offset(column_count);
+    void* memory = ::operator new(tiles * tile_bytes + tile_alignment);
+    base = static_cast<char*>(memory);
+    base += detail::align_up(
+        reinterpret_cast<std::uintptr_t>(base), tile_alignment
+    ) - reinterpret_cast<std::uintptr_t>(base);
+    return memory;
+}
+
+template<std::size_t N, class... Types>
+void arrays_tiled<N, Types...>::adopt(
+    void* new_memory, char* new_base, std::size_t tiles
+) {
+    relocate(new_base, indices());
+    ::operator delete(memory);
+
+    memory = new_memory;
+    base = new_base;
+    reserved = tiles * N;
+}
+
+template<std::size_t N, class... Types> template<std::size_t... I>
+void arrays_tiled<N, Types...>::relocate(
+    char* to, std::index_sequence<I...>
+) {
+    // tile by tile, a whole run of a column at once
+    for (std::size_t tile = 0; tile < tiles(); tile++) {
+        using expand = int[];
+        (void)expand{0, (detail::relocate(
+            element<I>(base, tile * N), element<I>(to, tile * N), used(tile),
+            std::is_trivially_copyable<Types>()
+        ), 0)...};
+    }
+}
+
+template<std::size_t N, class... Types>
+template<std::size_t... I, class... Args>
+void arrays_tiled<N, Types...>::construct(
+    char* tiles, std::index_sequence<I...>, Args&&... args
+) {
+    using expand = int[];
+    (void)expand{0, (
+        new (element<I>(tiles, rows)) Types(std::forward<Args>(args)), 0
+    )...};
+}
+
+template<std::size_t N, class... Types> template<std::size_t... I>
+void arrays_tiled<N, Types...>::move_row(
+    std::size_t from, std::size_t to, std::index_sequence<I...>
+) {
+    using expand = int[];
+    (void)expand{0, (
+        *element<I>(base, to) = std::move(*element<I>(base, from)), 0
+    )...};
+}
+
+template<std::size_t N, class... Types> template<std::size_t... I>
+void arrays_tiled<N, Types...>::destroy(
+    std::size_t first, std::size_t last, std::index_sequence<I...>
+) {
+    for (std::size_t row = first; row < last; row++) {
+        using expand = int[];
+        (void)expand{0, (detail::destroy(
+            element<I>(base, row), element<I>(base, row) + 1,
+            std::is_trivially_destructible<Types>()
+        ), 0)...};
+    }
+}
+
+}
+
+#endif // ARRAYS_TILED_H
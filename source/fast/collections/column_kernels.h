@@ -0,0 +1,661 @@
+#ifndef COLUMN_KERNELS_H
+#define COLUMN_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "span.h"
+
+namespace fast {
+
+/* Loops over single columns, as returned by arrays::get.
+ * float, double and int32_t use SSE2 or AVX2 if the compiler
+ * targets them (-msse2, -mavx2, -march=native), other types
+ * and the tails of columns use scalar code. Columns of
+ * simd_arrays are aligned and padded, so vector loads never
+ * split cache lines there, but any span works.
+ */
+
+/**
+ * @brief out[i] = function(in[i])
+ * Plain loop the compiler can vectorize, out has to be at least as long
+ */
+template<class In, class Out, class Function>
+void transform(span<In> in, span<Out> out, Function function);
+
+// out[i] = in[i] * factor + offset, in and out may be the same column
+template<class In, class Out>
+void multiply_add(
+    span<In> in, std::remove_const_t<In> factor,
+    std::remove_const_t<In> offset, span<Out> out
+);
+
+// folds the column with function, in order
+template<class Type, class Value, class Function>
+Value reduce(span<Type> column, Value initial, Function function);
+
+// the vector paths add in a different order, floats may round differently
+template<class Type>
+std::remove_const_t<Type> sum(span<Type> column);
+
+/**
+ * @brief write the indices of the elements satisfying predicate to out
+ * @param out Room for as many indices as the column has elements
+ * @return the number of indices written
+ */
+template<class Type, class Predicate>
+std::size_t select(span<Type> column, Predicate predicate, std::uint32_t* out);
+
+// select with predicate element > threshold
+template<class Type>
+std::size_t select_greater(
+    span<Type> column, std::remove_const_t<Type> threshold,
+    std::uint32_t* out
+);
+
+/**
+ * @brief out[i] = column[indices[i]]
+ * Indices have to be below 2^31, AVX2 reads them as signed.
+ */
+template<class Type, class Out>
+void gather(
+    span<Type> column, span<const std::uint32_t> indices, span<Out> out
+);
+
+/**
+ * @brief column[indices[i]] = values[i]
+ * Always scalar, vector scatters need AVX-512.
+ */
+template<class Type, class Out>
+void scatter(
+    span<Type> values, span<const std::uint32_t> indices, span<Out> column
+);
+
+namespace detail {
+    // scalar code, also used for the tails of the vector paths
+    template<class Type>
+    struct scalar_kernel {
+        static void multiply_add(
+            const Type* in, Type factor, Type offset, Type* out,
+            std::size_t size
+        );
+        static Type sum(const Type* in, std::size_t size);
+        static std::size_t select_greater(
+            const Type* in, Type threshold, std::uint32_t* out,
+            std::size_t size, std::uint32_t first
+        );
+        static void gather(
+            const Type* in, const std::uint32_t* indices, Type* out,
+            std::size_t size
+        );
+    };
+
+    template<class Type>
+    struct column_kernel : scalar_kernel<Type> {};
+
+#if defined(__SSE2__)
+    template<>
+    struct column_kernel<float> : scalar_kernel<float> {
+        static void multiply_add(
+            const float* in, float factor, float offset, float* out,
+            std::size_t size
+        );
+        static float sum(const float* in, std::size_t size);
+        static std::size_t select_greater(
+            const float* in, float threshold, std::uint32_t* out,
+            std::size_t size, std::uint32_t first
+        );
+#if defined(__AVX2__)
+        static void gather(
+            const float* in, const std::uint32_t* indices, float* out,
+            std::size_t size
+        );
+#endif
+    };
+
+    template<>
+    struct column_kernel<double> : scalar_kernel<double> {
+        static void multiply_add(
+            const double* in, double factor, double offset, double* out,
+            std::size_t size
+        );
+        static double sum(const double* in, std::size_t size);
+        static std::size_t select_greater(
+            const double* in, double threshold, std::uint32_t* out,
+            std::size_t size, std::uint32_t first
+        );
+#if defined(__AVX2__)
+        static void gather(
+            const double* in, const std::uint32_t* indices, double* out,
+            std::size_t size
+        );
+#endif
+    };
+
+    template<>
+    struct column_kernel<std::int32_t> : scalar_kernel<std::int32_t> {
+#if defined(__AVX2__)
+        // SSE2 has no 32 bit multiply
+        static void multiply_add(
+            const std::int32_t* in, std::int32_t factor, std::int32_t offset,
+            std::int32_t* out, std::size_t size
+        );
+        static void gather(
+            const std::int32_t* in, const std::uint32_t* indices,
+            std::int32_t* out, std::size_t size
+        );
+#endif
+        static std::int32_t sum(const std::int32_t* in, std::size_t size);
+        static std::size_t select_greater(
+            const std::int32_t* in, std::int32_t threshold,
+            std::uint32_t* out, std::size_t size, std::uint32_t first
+        );
+    };
+#endif
+
+    // appends first + i for every set bit i of mask, without branches
+    inline std::size_t append_indices(
+        int mask, int lanes, std::uint32_t first, std::uint32_t* out
+    );
+}
+
+
+template<class In, class Out, class Function>
+void transform(span<In> in, span<Out> out, Function function) {
+    std::size_t size = in.end() - in.begin();
+    In* source = in.begin();
+    Out* destination = out.begin();
+    for (std::size_t i = 0; i < size; i++) {
+        destination[i] = function(source[i]);
+    }
+}
+
+template<class In, class Out>
+void multiply_add(
+    span<In> in, std::remove_const_t<In> factor,
+    std::remove_const_t<In> offset, span<Out> out
+) {
+    static_assert(
+        std::is_same<std::remove_const_t<In>, Out>::value,
+        "in and out need the same element type"
+    );
+    detail::column_kernel<Out>::multiply_add(
+        in.begin(), factor, offset, out.begin(), in.end() - in.begin()
+    );
+}
+
+template<class Type, class Value, class Function>
+Value reduce(span<Type> column, Value initial, Function function) {
+    for (Type* i = column.begin(); i != column.end(); ++i) {
+        initial = function(initial, *i);
+    }
+    return initial;
+}
+
+template<class Type>
+std::remove_const_t<Type> sum(span<Type> column) {
+    return detail::column_kernel<std::remove_const_t<Type>>::sum(
+        column.begin(), column.end() - column.begin()
+    );
+}
+
+template<class Type, class Predicate>
+std::size_t select(
+    span<Type> column, Predicate predicate, std::uint32_t* out
+) {
+    std::size_t size = column.end() - column.begin();
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < size; i++) {
+        if (predicate(column.begin()[i])) {
+            out[count++] = static_cast<std::uint32_t>(i);
+        }
+    }
+    return count;
+}
+
+template<class Type>
+std::size_t select_greater(
+    span<Type> column, std::remove_const_t<Type> threshold,
+    std::uint32_t* out
+) {
+    return detail::column_kernel<std::remove_const_t<Type>>::select_greater(
+        column.begin(), threshold, out, column.end() - column.begin(), 0
+    );
+}
+
+template<class Type, class Out>
+void gather(
+    span<Type> column, span<const std::uint32_t> indices, span<Out> out
+) {
+    static_assert(
+        std::is_same<std::remove_const_t<Type>, Out>::value,
+        "column and out need the same element type"
+    );
+    detail::column_kernel<Out>::gather(
+        column.begin(), indices.begin(), out.begin(),
+        indices.end() - indices.begin()
+    );
+}
+
+template<class Type, class Out>
+void scatter(
+    span<Type> values, span<const std::uint32_t> indices, span<Out> column
+) {
+    std::size_t size = indices.end() - indices.begin();
+    for (std::size_t i = 0; i < size; i++) {
+        column.begin()[indices.begin()[i]] = values.begin()[i];
+    }
+}
+
+template<class Type>
+void detail::scalar_kernel<Type>::multiply_add(
+    const Type* in, Type factor, Type offset, Type* out, std::size_t size
+) {
+    for (std::size_t i = 0; i < size; i++) {
+        out[i] = in[i] * factor + offset;
+    }
+}
+
+template<class Type>
+Type detail::scalar_kernel<Type>::sum(const Type* in, std::size_t size) {
+    Type result = Type();
+    for (std::size_t i = 0; i < size; i++) {
+        result += in[i];
+    }
+    return result;
+}
+
+template<class Type>
+std::size_t detail::scalar_kernel<Type>::select_greater(
+    const Type* in, Type threshold, std::uint32_t* out, std::size_t size,
+    std::uint32_t first
+) {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < size; i++) {
+        out[count] = first + static_cast<std::uint32_t>(i);
+        count += in[i] > threshold;
+    }
+    return count;
+}
+
+template<class Type>
+void detail::scalar_kernel<Type>::gather(
+    const Type* in, const std::uint32_t* indices, Type* out, std::size_t size
+) {
+    for (std::size_t i = 0; i < size; i++) {
+        out[i] = in[indices[i]];
+    }
+}
+
+inline std::size_t detail::append_indices(
+    int mask, int lanes, std::uint32_t first, std::uint32_t* out
+) {
+    std::size_t count = 0;
+    for (int lane = 0; lane < lanes; lane++) {
+        out[count] = first + lane;
+        count += mask >> lane & 1;
+    }
+    return count;
+}
+
+#if defined(__SSE2__)
+#if defined(__AVX2__)
+inline void detail::column_kernel<float>::multiply_add(
+    const float* in, float factor, float offset, float* out, std::size_t size
+) {
+    __m256 f = _mm256_set1_ps(factor);
+    __m256 o = _mm256_set1_ps(offset);
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256 x = _mm256_loadu_ps(in + i);
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(x, f), o));
+    }
+    scalar_kernel::multiply_add(in + i, factor, offset, out + i, size - i);
+}
+
+inline float detail::column_kernel<float>::sum(
+    const float* in, std::size_t size
+) {
+    __m256 total = _mm256_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        total = _mm256_add_ps(total, _mm256_loadu_ps(in + i));
+    }
+
+    __m128 half = _mm_add_ps(
+        _mm256_castps256_ps128(total), _mm256_extractf128_ps(total, 1)
+    );
+    float lanes[4];
+    _mm_storeu_ps(lanes, half);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+        scalar_kernel::sum(in + i, size - i);
+}
+
+inline std::size_t detail::column_kernel<float>::select_greater(
+    const float* in, float threshold, std::uint32_t* out, std::size_t size,
+    std::uint32_t first
+) {
+    __m256 t = _mm256_set1_ps(threshold);
+    std::size_t count = 0;
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256 greater = _mm256_cmp_ps(_mm256_loadu_ps(in + i), t, _CMP_GT_OQ);
+        count += append_indices(
+            _mm256_movemask_ps(greater), 8,
+            first + static_cast<std::uint32_t>(i), out + count
+        );
+    }
+    return count + scalar_kernel::select_greater(
+        in + i, threshold, out + count, size - i,
+        first + static_cast<std::uint32_t>(i)
+    );
+}
+
+inline void detail::column_kernel<float>::gather(
+    const float* in, const std::uint32_t* indices, float* out,
+    std::size_t size
+) {
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256i index = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(indices + i)
+        );
+        _mm256_storeu_ps(out + i, _mm256_i32gather_ps(in, index, 4));
+    }
+    scalar_kernel::gather(in, indices + i, out + i, size - i);
+}
+
+inline void detail::column_kernel<double>::multiply_add(
+    const double* in, double factor, double offset, double* out,
+    std::size_t size
+) {
+    __m256d f = _mm256_set1_pd(factor);
+    __m256d o = _mm256_set1_pd(offset);
+    std::size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m256d x = _mm256_loadu_pd(in + i);
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_mul_pd(x, f), o));
+    }
+    scalar_kernel::multiply_add(in + i, factor, offset, out + i, size - i);
+}
+
+inline double detail::column_kernel<double>::sum(
+    const double* in, std::size_t size
+) {
+    __m256d total = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        total = _mm256_add_pd(total, _mm256_loadu_pd(in + i));
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, total);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+        scalar_kernel::sum(in + i, size - i);
+}
+
+inline std::size_t detail::column_kernel<double>::select_greater(
+    const double* in, double threshold, std::uint32_t* out, std::size_t size,
+    std::uint32_t first
+) {
+    __m256d t = _mm256_set1_pd(threshold);
+    std::size_t count = 0;
+    std::size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m256d greater =
+            _mm256_cmp_pd(_mm256_loadu_pd(in + i), t, _CMP_GT_OQ);
+        count += append_indices(
+            _mm256_movemask_pd(greater), 4,
+            first + static_cast<std::uint32_t>(i), out + count
+        );
+    }
+    return count + scalar_kernel::select_greater(
+        in + i, threshold, out + count, size - i,
+        first + static_cast<std::uint32_t>(i)
+    );
+}
+
+inline void detail::column_kernel<double>::gather(
+    const double* in, const std::uint32_t* indices, double* out,
+    std::size_t size
+) {
+    std::size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128i index = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(indices + i)
+        );
+        // the masked form, the plain one trips -Wmaybe-uninitialized in gcc
+        __m256d gathered = _mm256_mask_i32gather_pd(
+            _mm256_setzero_pd(), in, index,
+            _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8
+        );
+        _mm256_storeu_pd(out + i, gathered);
+    }
+    scalar_kernel::gather(in, indices + i, out + i, size - i);
+}
+
+inline void detail::column_kernel<std::int32_t>::multiply_add(
+    const std::int32_t* in, std::int32_t factor, std::int32_t offset,
+    std::int32_t* out, std::size_t size
+) {
+    __m256i f = _mm256_set1_epi32(factor);
+    __m256i o = _mm256_set1_epi32(offset);
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256i x =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(out + i),
+            _mm256_add_epi32(_mm256_mullo_epi32(x, f), o)
+        );
+    }
+    scalar_kernel::multiply_add(in + i, factor, offset, out + i, size - i);
+}
+
+inline std::int32_t detail::column_kernel<std::int32_t>::sum(
+    const std::int32_t* in, std::size_t size
+) {
+    __m256i total = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        total = _mm256_add_epi32(
+            total,
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i))
+        );
+    }
+
+    std::int32_t lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), total);
+    std::int32_t result = scalar_kernel::sum(in + i, size - i);
+    for (std::int32_t lane : lanes) {
+        result += lane;
+    }
+    return result;
+}
+
+inline std::size_t detail::column_kernel<std::int32_t>::select_greater(
+    const std::int32_t* in, std::int32_t threshold, std::uint32_t* out,
+    std::size_t size, std::uint32_t first
+) {
+    __m256i t = _mm256_set1_epi32(threshold);
+    std::size_t count = 0;
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256i greater = _mm256_cmpgt_epi32(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)), t
+        );
+        count += append_indices(
+            _mm256_movemask_ps(_mm256_castsi256_ps(greater)), 8,
+            first + static_cast<std::uint32_t>(i), out + count
+        );
+    }
+    return count + scalar_kernel::select_greater(
+        in + i, threshold, out + count, size - i,
+        first + static_cast<std::uint32_t>(i)
+    );
+}
+
+inline void detail::column_kernel<std::int32_t>::gather(
+    const std::int32_t* in, const std::uint32_t* indices, std::int32_t* out,
+    std::size_t size
+) {
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256i index = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(indices + i)
+        );
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(out + i),
+            _mm256_i32gather_epi32(in, index, 4)
+        );
+    }
+    scalar_kernel::gather(in, indices + i, out + i, size - i);
+}
+#else
+inline void detail::column_kernel<float>::multiply_add(
+    const float* in, float factor, float offset, float* out, std::size_t size
+) {
+    __m128 f = _mm_set1_ps(factor);
+    __m128 o = _mm_set1_ps(offset);
+    std::size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128 x = _mm_loadu_ps(in + i);
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(x, f), o));
+    }
+    scalar_kernel::multiply_add(in + i, factor, offset, out + i, size - i);
+}
+
+inline float detail::column_kernel<float>::sum(
+    const float* in, std::size_t size
+) {
+    __m128 total = _mm_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        total = _mm_add_ps(total, _mm_loadu_ps(in + i));
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, total);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+        scalar_kernel::sum(in + i, size - i);
+}
+
+inline std::size_t detail::column_kernel<float>::select_greater(
+    const float* in, float threshold, std::uint32_t* out, std::size_t size,
+    std::uint32_t first
+) {
+    __m128 t = _mm_set1_ps(threshold);
+    std::size_t count = 0;
+    std::size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128 greater = _mm_cmpgt_ps(_mm_loadu_ps(in + i), t);
+        count += append_indices(
+            _mm_movemask_ps(greater), 4,
+            first + static_cast<std::uint32_t>(i), out + count
+        );
+    }
+    return count + scalar_kernel::select_greater(
+        in + i, threshold, out + count, size - i,
+        first + static_cast<std::uint32_t>(i)
+    );
+}
+
+inline void detail::column_kernel<double>::multiply_add(
+    const double* in, double factor, double offset, double* out,
+    std::size_t size
+) {
+    __m128d f = _mm_set1_pd(factor);
+    __m128d o = _mm_set1_pd(offset);
+    std::size_t i = 0;
+    for (; i + 2 <= size; i += 2) {
+        __m128d x = _mm_loadu_pd(in + i);
+        _mm_storeu_pd(out + i, _mm_add_pd(_mm_mul_pd(x, f), o));
+    }
+    scalar_kernel::multiply_add(in + i, factor, offset, out + i, size - i);
+}
+
+inline double detail::column_kernel<double>::sum(
+    const double* in, std::size_t size
+) {
+    __m128d total = _mm_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 2 <= size; i += 2) {
+        total = _mm_add_pd(total, _mm_loadu_pd(in + i));
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, total);
+    return lanes[0] + lanes[1] + scalar_kernel::sum(in + i, size - i);
+}
+
+inline std::size_t detail::column_kernel<double>::select_greater(
+    const double* in, double threshold, std::uint32_t* out, std::size_t size,
+    std::uint32_t first
+) {
+    __m128d t = _mm_set1_pd(threshold);
+    std::size_t count = 0;
+    std::size_t i = 0;
+    for (; i + 2 <= size; i += 2) {
+        __m128d greater = _mm_cmpgt_pd(_mm_loadu_pd(in + i), t);
+        count += append_indices(
+            _mm_movemask_pd(greater), 2,
+            first + static_cast<std::uint32_t>(i), out + count
+        );
+    }
+    return count + scalar_kernel::select_greater(
+        in + i, threshold, out + count, size - i,
+        first + static_cast<std::uint32_t>(i)
+    );
+}
+
+inline std::int32_t detail::column_kernel<std::int32_t>::sum(
+    const std::int32_t* in, std::size_t size
+) {
+    __m128i total = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        total = _mm_add_epi32(
+            total, _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))
+        );
+    }
+
+    std::int32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), total);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+        scalar_kernel::sum(in + i, size - i);
+}
+
+inline std::size_t detail::column_kernel<std::int32_t>::select_greater(
+    const std::int32_t* in, std::int32_t threshold, std::uint32_t* out,
+    std::size_t size, std::uint32_t first
+) {
+    __m128i t = _mm_set1_epi32(threshold);
+    std::size_t count = 0;
+    std::size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128i greater = _mm_cmpgt_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), t
+        );
+        count += append_indices(
+            _mm_movemask_ps(_mm_castsi128_ps(greater)), 4,
+            first + static_cast<std::uint32_t>(i), out + count
+        );
+    }
+    return count + scalar_kernel::select_greater(
+        in + i, threshold, out + count, size - i,
+        first + static_cast<std::uint32_t>(i)
+    );
+}
+#endif
+#endif
+
+}
+
+#endif // COLUMN_KERNELS_H
@@ -0,0 +1,508 @@
+#ifndef MAPPED_ARRAYS_H
+#define MAPPED_ARRAYS_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+// std::min and std::max instead of the macros
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "arrays.h"
+#include "span.h"
+
+namespace fast {
+
+/* Columnar file for arrays of trivially copyable types:
+ *
+ * header: magic, byte order, column count, row count
+ * one entry per column: type fingerprint, offset, bytes
+ * column blobs, each at a multiple of simd_alignment
+ *
+ * The fingerprint holds size, alignment and kind of a type,
+ * it catches columns of a different layout, not different
+ * structs of the same layout.
+ */
+
+/**
+ * @brief write the rows of a to path, replacing the file
+ * @return false if the file couldn't be written
+ */
+template<std::size_t Alignment, class... Types>
+bool save(const aligned_arrays<Alignment, Types...>& a, const char* path);
+
+template<class... Types>
+struct mapped_arrays {
+    /* Columns of a file written by save, mapped into memory.
+     * Opening only reads the header, pages of the columns are
+     * read on first access. Read only mappings share pages with
+     * the page cache, copy_on_write ones get a private copy of
+     * every page written to, the file never changes.
+     */
+
+    mapped_arrays();
+    mapped_arrays(mapped_arrays&& other) noexcept;
+    ~mapped_arrays();
+
+    mapped_arrays(const mapped_arrays&) = delete;
+
+    mapped_arrays& operator=(mapped_arrays&& other) noexcept;
+    mapped_arrays& operator=(const mapped_arrays&) = delete;
+
+    /**
+     * @brief map a file, closing the previous one
+     * @param copy_on_write Allow writes through get_mutable
+     * @return false if the file can't be mapped or its columns don't match
+     */
+    bool open(const char* path, bool copy_on_write = false);
+    void close();
+    bool is_open() const;
+
+    template<class Type>
+    span<const Type> get() const;
+
+    template<int N>
+    span<const typename std::tuple_element<N, std::tuple<Types...>>::type>
+    get() const;
+
+    /**
+     * @brief writable column, only for mappings opened with copy_on_write
+     * @return an empty span for read only mappings
+     */
+    template<class Type>
+    span<Type> get_mutable();
+
+    template<int N>
+    span<typename std::tuple_element<N, std::tuple<Types...>>::type>
+    get_mutable();
+
+    std::size_t size() const;
+
+    // copy the rows into a table that can grow
+    template<std::size_t Alignment = 1>
+    aligned_arrays<Alignment, Types...> promote() const;
+
+private:
+    static constexpr std::size_t column_count = sizeof...(Types);
+    typedef std::index_sequence_for<Types...> indices;
+
+    template<std::size_t... I>
+    bool place(std::size_t file_size, std::index_sequence<I...>);
+    template<std::size_t Alignment, std::size_t... I>
+    void promote(
+        aligned_arrays<Alignment, Types...>& a, std::index_sequence<I...>
+    ) const;
+
+    char* memory;
+    std::size_t bytes;
+    bool writable;
+    std::tuple<Types*...> columns;
+    std::size_t rows;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+};
+
+namespace detail {
+    constexpr char mapped_arrays_magic[8] = {
+        'f', 'a', 's', 't', 'c', 'o', 'l', '1'
+    };
+    // reads differently on a machine of the other byte order
+    constexpr std::uint32_t mapped_arrays_byte_order = 0x01020304;
+
+    struct mapped_arrays_header {
+        char magic[8];
+        std::uint32_t byte_order;
+        std::uint32_t columns;
+        std::uint64_t rows;
+    };
+
+    struct mapped_arrays_column {
+        std::uint64_t fingerprint;
+        std::uint64_t offset;
+        std::uint64_t bytes;
+    };
+
+    template<class Type>
+    constexpr std::uint64_t type_fingerprint();
+
+    template<class... Types>
+    constexpr std::size_t mapped_arrays_data_offset();
+
+    template<class... Types>
+    constexpr bool all_trivially_copyable();
+
+    template<std::size_t Alignment, class... Types, std::size_t... I>
+    bool save(
+        const aligned_arrays<Alignment, Types...>& a, const char* path,
+        std::index_sequence<I...>
+    );
+
+    // zeros up to offset, false on errors
+    inline bool pad_file(
+        std::FILE* file, std::size_t& position, std::size_t offset
+    );
+}
+
+
+template<std::size_t Alignment, class... Types>
+bool save(const aligned_arrays<Alignment, Types...>& a, const char* path) {
+    static_assert(
+        detail::all_trivially_copyable<Types...>(),
+        "only trivially copyable columns can be saved"
+    );
+    return detail::save(a, path, std::index_sequence_for<Types...>());
+}
+
+template<class... Types>
+mapped_arrays<Types...>::mapped_arrays() :
+    memory(nullptr),
+    bytes(0),
+    writable(false),
+    columns(static_cast<Types*>(nullptr)...),
+    rows(0)
+#ifdef _WIN32
+    , file(INVALID_HANDLE_VALUE),
+    mapping(nullptr)
+#endif
+{
+    static_assert(
+        detail::all_trivially_copyable<Types...>(),
+        "only trivially copyable columns can be mapped"
+    );
+}
+
+template<class... Types>
+mapped_arrays<Types...>::mapped_arrays(mapped_arrays&& other) noexcept :
+    mapped_arrays()
+{
+    *this = std::move(other);
+}
+
+template<class... Types>
+mapped_arrays<Types...>::~mapped_arrays() {
+    close();
+}
+
+template<class... Types>
+mapped_arrays<Types...>& mapped_arrays<Types...>::operator=(
+    mapped_arrays&& other
+) noexcept {
+    if (this != &other) {
+        close();
+        std::swap(memory, other.memory);
+        std::swap(bytes, other.bytes);
+        std::swap(writable, other.writable);
+        std::swap(columns, other.columns);
+        std::swap(rows, other.rows);
+#ifdef _WIN32
+        std::swap(file, other.file);
+        std::swap(mapping, other.mapping);
+#endif
+    }
+    return *this;
+}
+
+template<class... Types>
+bool mapped_arrays<Types...>::open(const char* path, bool copy_on_write) {
+    close();
+
+#ifdef _WIN32
+    file = CreateFileA(
+        path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr
+    );
+    LARGE_INTEGER size;
+    if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size)) {
+        close();
+        return false;
+    }
+    bytes = static_cast<std::size_t>(size.QuadPart);
+
+    if (bytes > 0) {
+        mapping = CreateFileMappingA(
+            file, nullptr, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY,
+            0, 0, nullptr
+        );
+        if (mapping != nullptr) {
+            memory = static_cast<char*>(MapViewOfFile(
+                mapping, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ,
+                0, 0, 0
+            ));
+        }
+    }
+#else
+    int descriptor = ::open(path, O_RDONLY);
+    struct stat status;
+    if (descriptor < 0 || fstat(descriptor, &status) != 0) {
+        if (descriptor >= 0) {
+            ::close(descriptor);
+        }
+        return false;
+    }
+    bytes = static_cast<std::size_t>(status.st_size);
+
+    if (bytes > 0) {
+        // private mappings copy a page on the first write to it
+        void* mapped = mmap(
+            nullptr, bytes,
+            copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ,
+            copy_on_write ? MAP_PRIVATE : MAP_SHARED, descriptor, 0
+        );
+        memory = mapped == MAP_FAILED ? nullptr : static_cast<char*>(mapped);
+    }
+    // the mapping keeps the file alive
+    ::close(descriptor);
+#endif
+
+    writable = copy_on_write;
+    if (memory == nullptr || !place(bytes, indices())) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+template<class... Types>
+void mapped_arrays<Types...>::close() {
+#ifdef _WIN32
+    if (memory != nullptr) {
+        UnmapViewOfFile(memory);
+    }
+    if (mapping != nullptr) {
+        CloseHandle(mapping);
+    }
+    if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+    }
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+#else
+    if (memory != nullptr) {
+        munmap(memory, bytes);
+    }
+#endif
+
+    memory = nullptr;
+    bytes = 0;
+    writable = false;
+    columns = std::tuple<Types*...>(static_cast<Types*>(nullptr)...);
+    rows = 0;
+}
+
+template<class... Types>
+bool mapped_arrays<Types...>::is_open() const {
+    return memory != nullptr;
+}
+
+template<class... Types> template<class Type>
+span<const Type> mapped_arrays<Types...>::get() const {
+    const Type* begin = std::get<Type*>(columns);
+    return span<const Type>(begin, begin + rows);
+}
+
+template<class... Types> template<int N>
+span<const typename std::tuple_element<N, std::tuple<Types...>>::type>
+mapped_arrays<Types...>::get() const {
+    typedef typename std::tuple_element<N, std::tuple<Types...>>::type type;
+    const type* begin = std::get<N>(columns);
+    return span<const type>(begin, begin + rows);
+}
+
+template<class... Types> template<class Type>
+span<Type> mapped_arrays<Types...>::get_mutable() {
+    // writing to a read only mapping faults
+    assert(writable || !is_open());
+    Type* begin = std::get<Type*>(columns);
+    return span<Type>(begin, begin + (writable ? rows : 0));
+}
+
+template<class... Types> template<int N>
+span<typename std::tuple_element<N, std::tuple<Types...>>::type>
+mapped_arrays<Types...>::get_mutable() {
+    assert(writable || !is_open());
+    auto begin = std::get<N>(columns);
+    return span<typename std::tuple_element<N, std::tuple<Types...>>::type>(
+        begin, begin + (writable ? rows : 0)
+    );
+}
+
+template<class... Types>
+std::size_t mapped_arrays<Types...>::size() const {
+    return rows;
+}
+
+template<class... Types> template<std::size_t Alignment>
+aligned_arrays<Alignment, Types...> mapped_arrays<Types...>::promote() const {
+    aligned_arrays<Alignment, Types...> a;
+    a.reserve(rows);
+    promote(a, indices());
+    return a;
+}
+
+template<class... Types> template<std::size_t... I>
+bool mapped_arrays<Types...>::place(
+    std::size_t file_size, std::index_sequence<I...>
+) {
+    constexpr std::size_t data_offset =
+        detail::mapped_arrays_data_offset<Types...>();
+    if (file_size < data_offset) {
+        return false;
+    }
+
+    detail::mapped_arrays_header header;
+    std::memcpy(&header, memory, sizeof(header));
+    if (
+        std::memcmp(
+            header.magic, detail::mapped_arrays_magic, sizeof(header.magic)
+        ) != 0 ||
+        header.byte_order != detail::mapped_arrays_byte_order ||
+        header.columns != column_count
+    ) {
+        return false;
+    }
+
+    const std::uint64_t fingerprints[] = {detail::type_fingerprint<Types>()...};
+    const std::size_t sizes[] = {sizeof(Types)...};
+    detail::mapped_arrays_column entries[column_count];
+    std::memcpy(entries, memory + sizeof(header), sizeof(entries));
+
+    for (std::size_t i = 0; i < column_count; i++) {
+        const detail::mapped_arrays_column& e = entries[i];
+        // rows is checked against the file before it's multiplied,
+        // so a corrupt count can't wrap around to a matching size
+        if (
+            e.fingerprint != fingerprints[i] ||
+            e.offset % simd_alignment != 0 ||
+            e.offset > file_size ||
+            header.rows > (file_size - e.offset) / sizes[i] ||
+            e.bytes != header.rows * sizes[i]
+        ) {
+            return false;
+        }
+    }
+
+    rows = static_cast<std::size_t>(header.rows);
+    columns = std::tuple<Types*...>(
+        reinterpret_cast<Types*>(memory + entries[I].offset)...
+    );
+    return true;
+}
+
+template<class... Types> template<std::size_t Alignment, std::size_t... I>
+void mapped_arrays<Types...>::promote(
+    aligned_arrays<Alignment, Types...>& a, std::index_sequence<I...>
+) const {
+    for (std::size_t row = 0; row < rows; row++) {
+        a.emplace_back(std::get<I>(columns)[row]...);
+    }
+}
+
+template<class Type>
+constexpr std::uint64_t detail::type_fingerprint() {
+    std::uint64_t kind =
+        std::is_floating_point<Type>::value ? 1 :
+        std::is_integral<Type>::value && std::is_signed<Type>::value ? 2 :
+        std::is_integral<Type>::value ? 3 :
+        std::is_enum<Type>::value ? 4 : 5;
+    return kind << 48 | std::uint64_t(alignof(Type)) << 32 | sizeof(Type);
+}
+
+template<class... Types>
+constexpr std::size_t detail::mapped_arrays_data_offset() {
+    return align_up(
+        sizeof(mapped_arrays_header) +
+            sizeof...(Types) * sizeof(mapped_arrays_column),
+        simd_alignment
+    );
+}
+
+template<class... Types>
+constexpr bool detail::all_trivially_copyable() {
+    const bool copyable[] = {std::is_trivially_copyable<Types>::value...};
+    for (bool c : copyable) {
+        if (!c) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<std::size_t Alignment, class... Types, std::size_t... I>
+bool detail::save(
+    const aligned_arrays<Alignment, Types...>& a, const char* path,
+    std::index_sequence<I...>
+) {
+    const std::size_t sizes[] = {sizeof(Types)...};
+    const void* data[] = {a.template get<I>().begin()...};
+    constexpr std::size_t count = sizeof...(Types);
+
+    mapped_arrays_header header;
+    std::memcpy(header.magic, mapped_arrays_magic, sizeof(header.magic));
+    header.byte_order = mapped_arrays_byte_order;
+    header.columns = count;
+    header.rows = a.size();
+
+    mapped_arrays_column entries[count] = {
+        {type_fingerprint<Types>(), 0, 0}...
+    };
+    std::size_t offset = mapped_arrays_data_offset<Types...>();
+    for (std::size_t i = 0; i < count; i++) {
+        entries[i].offset = offset;
+        entries[i].bytes = sizes[i] * a.size();
+        offset = align_up(offset + entries[i].bytes, simd_alignment);
+    }
+
+    std::FILE* file = std::fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    bool written =
+        std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+        std::fwrite(entries, sizeof(entries), 1, file) == 1;
+
+    std::size_t position = sizeof(header) + sizeof(entries);
+    for (std::size_t i = 0; written && i < count; i++) {
+        written = pad_file(file, position, entries[i].offset) && (
+            entries[i].bytes == 0 ||
+            std::fwrite(data[i], entries[i].bytes, 1, file) == 1
+        );
+        position += entries[i].bytes;
+    }
+
+    return std::fclose(file) == 0 && written;
+}
+
+inline bool detail::pad_file(
+    std::FILE* file, std::size_t& position, std::size_t offset
+) {
+    static const char zeros[simd_alignment] = {};
+    assert(offset - position <= sizeof(zeros));
+    std::size_t padding = offset - position;
+    position = offset;
+    return padding == 0 || std::fwrite(zeros, padding, 1, file) == 1;
+}
+
+}
+
+#endif // MAPPED_ARRAYS_H
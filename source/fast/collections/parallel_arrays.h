@@ -0,0 +1,176 @@
+#ifndef PARALLEL_ARRAYS_H
+#define PARALLEL_ARRAYS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+#include "arrays.h"
+#include "../threading/thread_pool.h"
+
+namespace fast {
+
+/* Row and column passes over arrays on a thread_pool. Rows are
+ * split into chunks that fit the L1 cache together with all
+ * their columns, functions get the columns of one row as
+ * references, so they can be inlined into the chunk loop.
+ */
+
+// bytes of all columns a chunk of rows should touch
+constexpr std::size_t parallel_chunk_bytes = 32 * 1024;
+
+/**
+ * @brief call function(Types&...) for every row, on the pool
+ * Rows are independent, function must not insert or erase.
+ */
+template<std::size_t Alignment, class... Types, class Function>
+void parallel_for_each(
+    thread_pool& pool, aligned_arrays<Alignment, Types...>& a,
+    Function function
+);
+
+/**
+ * @brief column Out = function(column In...) for every row, on the pool
+ * Columns are selected by index like arrays::get<N>.
+ */
+template<int Out, int... In, std::size_t Alignment, class... Types,
+    class Function>
+void parallel_transform(
+    thread_pool& pool, aligned_arrays<Alignment, Types...>& a,
+    Function function
+);
+
+/**
+ * @brief call function(span<T>) once per column, columns concurrently
+ * For passes where every column is processed on its own,
+ * function is usually a generic lambda.
+ */
+template<std::size_t Alignment, class... Types, class Function>
+void parallel_columns(
+    thread_pool& pool, aligned_arrays<Alignment, Types...>& a,
+    Function function
+);
+
+namespace detail {
+    // rows per task, small enough for the cache, enough tasks for the pool
+    template<class... Types>
+    std::size_t parallel_grain(const thread_pool& pool, std::size_t rows);
+
+    template<std::size_t Alignment, class... Types, std::size_t... I>
+    std::tuple<Types*...> column_pointers(
+        aligned_arrays<Alignment, Types...>& a, std::index_sequence<I...>
+    );
+
+    template<std::size_t Alignment, class... Types, class Function,
+        std::size_t... I>
+    void parallel_for_each(
+        thread_pool& pool, aligned_arrays<Alignment, Types...>& a,
+        Function& function, std::index_sequence<I...>
+    );
+
+    template<std::size_t Alignment, class... Types, class Function,
+        std::size_t... I>
+    void call_column(
+        aligned_arrays<Alignment, Types...>& a, std::size_t column,
+        Function& function, std::index_sequence<I...>
+    );
+}
+
+
+template<std::size_t Alignment, class... Types, class Function>
+void parallel_for_each(
+    thread_pool& pool, aligned_arrays<Alignment, Types...>& a,
+    Function function
+) {
+    detail::parallel_for_each(
+        pool, a, function, std::index_sequence_for<Types...>()
+    );
+}
+
+template<int Out, int... In, std::size_t Alignment, class... Types,
+    class Function>
+void parallel_transform(
+    thread_pool& pool, aligned_arrays<Alignment, Types...>& a,
+    Function function
+) {
+    auto columns = detail::column_pointers(
+        a, std::index_sequence_for<Types...>()
+    );
+
+    // only the selected columns are touched, size chunks for them
+    std::size_t grain = detail::parallel_grain<
+        typename std::tuple_element<Out, std::tuple<Types...>>::type,
+        typename std::tuple_element<In, std::tuple<Types...>>::type...
+    >(pool, a.size());
+
+    pool.parallel_for(0, a.size(), [&](std::size_t row) {
+        std::get<Out>(columns)[row] =
+            function(std::get<In>(columns)[row]...);
+    }, grain);
+}
+
+template<std::size_t Alignment, class... Types, class Function>
+void parallel_columns(
+    thread_pool& pool, aligned_arrays<Alignment, Types...>& a,
+    Function function
+) {
+    pool.parallel_for(0, sizeof...(Types), [&](std::size_t column) {
+        detail::call_column(
+            a, column, function, std::index_sequence_for<Types...>()
+        );
+    }, 1);
+}
+
+template<class... Types>
+std::size_t detail::parallel_grain(
+    const thread_pool& pool, std::size_t rows
+) {
+    const std::size_t sizes[] = {sizeof(Types)...};
+    std::size_t row_bytes = 0;
+    for (std::size_t size : sizes) {
+        row_bytes += size;
+    }
+
+    std::size_t cache_rows =
+        std::max<std::size_t>(1, parallel_chunk_bytes / row_bytes);
+    std::size_t balanced_rows =
+        std::max<std::size_t>(1, rows / (4 * pool.size()));
+    return std::min(cache_rows, balanced_rows);
+}
+
+template<std::size_t Alignment, class... Types, std::size_t... I>
+std::tuple<Types*...> detail::column_pointers(
+    aligned_arrays<Alignment, Types...>& a, std::index_sequence<I...>
+) {
+    return std::tuple<Types*...>(a.template get<I>().begin()...);
+}
+
+template<std::size_t Alignment, class... Types, class Function,
+    std::size_t... I>
+void detail::parallel_for_each(
+    thread_pool& pool, aligned_arrays<Alignment, Types...>& a,
+    Function& function, std::index_sequence<I...>
+) {
+    auto columns = column_pointers(a, std::index_sequence<I...>());
+
+    pool.parallel_for(0, a.size(), [&](std::size_t row) {
+        function(std::get<I>(columns)[row]...);
+    }, parallel_grain<Types...>(pool, a.size()));
+}
+
+template<std::size_t Alignment, class... Types, class Function,
+    std::size_t... I>
+void detail::call_column(
+    aligned_arrays<Alignment, Types...>& a, std::size_t column,
+    Function& function, std::index_sequence<I...>
+) {
+    using expand = int[];
+    (void)expand{0, (
+        column == I ? (function(a.template get<I>()), 0) : 0
+    )...};
+}
+
+}
+
+#endif // PARALLEL_ARRAYS_H
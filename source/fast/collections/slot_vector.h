@@ -0,0 +1,189 @@
+#ifndef SLOT_VECTOR_H
+#define SLOT_VECTOR_H
+
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "arrays.h"
+
+namespace fast {
+
+/* An unordered_vector with copyable handles. Elements are dense
+ * in an arrays column next to the slot that refers to them,
+ * erase moves the last element into the gap and fixes its slot.
+ * Handles are a slot index and the generation of the slot when
+ * the element was inserted. Insert and erase both bump the
+ * generation, so it's odd while the slot holds an element, and
+ * handles to erased or reused slots are detected, not followed.
+ */
+template<class T>
+struct slot_vector {
+    // 8 bytes, trivially copyable, can be stored or written anywhere
+    struct handle {
+        std::uint32_t index = no_slot;
+        std::uint32_t generation = 0;
+
+        bool operator==(const handle& rhs) const;
+        bool operator!=(const handle& rhs) const;
+    };
+
+    handle insert(T&& t);
+    handle insert(const T& t);
+    // false if h was erased already
+    bool erase(handle h);
+
+    bool contains(handle h) const;
+    // nullptr if h was erased
+    T* get(handle h);
+    const T* get(handle h) const;
+    T& operator[](handle h);
+    const T& operator[](handle h) const;
+
+    T* begin();
+    T* end();
+
+    std::size_t size() const;
+    void reserve(std::size_t capacity);
+
+private:
+    static constexpr std::uint32_t no_slot = UINT32_MAX;
+
+    struct slot {
+        // row of the element, next free slot if erased
+        std::uint32_t row;
+        // odd while the slot is in use
+        std::uint32_t generation;
+    };
+
+    template<class Value>
+    handle emplace(Value&& value);
+
+    // element and the index of its slot
+    arrays<T, std::uint32_t> elements;
+    std::vector<slot> slots;
+    std::uint32_t free_slots = no_slot;
+};
+
+
+template<class T>
+constexpr std::uint32_t slot_vector<T>::no_slot;
+
+template<class T>
+bool slot_vector<T>::handle::operator==(const handle& rhs) const {
+    return index == rhs.index && generation == rhs.generation;
+}
+
+template<class T>
+bool slot_vector<T>::handle::operator!=(const handle& rhs) const {
+    return !(*this == rhs);
+}
+
+template<class T>
+typename slot_vector<T>::handle slot_vector<T>::insert(T&& t) {
+    return emplace(std::move(t));
+}
+
+template<class T>
+typename slot_vector<T>::handle slot_vector<T>::insert(const T& t) {
+    return emplace(t);
+}
+
+template<class T>
+bool slot_vector<T>::erase(handle h) {
+    if (!contains(h)) {
+        return false;
+    }
+
+    std::uint32_t row = slots[h.index].row;
+    elements.erase(elements.begin() + row);
+    if (row < elements.size()) {
+        // the last element moved into row
+        slots[elements.template get<1>().begin()[row]].row = row;
+    }
+
+    slots[h.index].generation++;
+    slots[h.index].row = free_slots;
+    free_slots = h.index;
+    return true;
+}
+
+template<class T>
+bool slot_vector<T>::contains(handle h) const {
+    // free slots have even generations, their row is a free list link
+    return (h.generation & 1) != 0 && h.index < slots.size() &&
+        slots[h.index].generation == h.generation;
+}
+
+template<class T>
+T* slot_vector<T>::get(handle h) {
+    if (!contains(h)) {
+        return nullptr;
+    }
+    return elements.template get<0>().begin() + slots[h.index].row;
+}
+
+template<class T>
+const T* slot_vector<T>::get(handle h) const {
+    if (!contains(h)) {
+        return nullptr;
+    }
+    return elements.template get<0>().begin() + slots[h.index].row;
+}
+
+template<class T>
+T& slot_vector<T>::operator[](handle h) {
+    assert(contains(h));
+    return elements.template get<0>().begin()[slots[h.index].row];
+}
+
+template<class T>
+const T& slot_vector<T>::operator[](handle h) const {
+    assert(contains(h));
+    return elements.template get<0>().begin()[slots[h.index].row];
+}
+
+template<class T>
+T* slot_vector<T>::begin() {
+    return elements.template get<0>().begin();
+}
+
+template<class T>
+T* slot_vector<T>::end() {
+    return elements.template get<0>().end();
+}
+
+template<class T>
+std::size_t slot_vector<T>::size() const {
+    return elements.size();
+}
+
+template<class T>
+void slot_vector<T>::reserve(std::size_t capacity) {
+    elements.reserve(capacity);
+    slots.reserve(capacity);
+}
+
+template<class T> template<class Value>
+typename slot_vector<T>::handle slot_vector<T>::emplace(Value&& value) {
+    if (free_slots == no_slot) {
+        // a new slot starts out free, so a throwing element leaves no trace
+        assert(slots.size() < no_slot);
+        slots.push_back(slot{no_slot, 0});
+        free_slots = std::uint32_t(slots.size() - 1);
+    }
+
+    std::uint32_t index = free_slots;
+    std::uint32_t row = std::uint32_t(elements.size());
+    elements.emplace_back(std::forward<Value>(value), index);
+
+    free_slots = slots[index].row;
+    slots[index].row = row;
+    slots[index].generation++;
+    return handle{index, slots[index].generation};
+}
+
+}
+
+#endif // SLOT_VECTOR_H
@@ -2,6 +2,7 @@
 #define SPAN_H
 
 #include <memory>
+#include <type_traits>
 
 namespace fast {
 
@@ -25,6 +26,15 @@ struct span {
     span();
     span(Type* begin, Type* end);
     span(const unique_span<Type>& o);
+    // span<T> to span<const T>, not to base classes of a different size
+    template<
+        class Other,
+        class = std::enable_if_t<
+            std::is_const<Type>::value &&
+            std::is_same<std::remove_const_t<Type>, Other>::value
+        >
+    >
+    span(const span<Other>& o);
 
     Type* begin() const;
     Type* end() const;
@@ -71,6 +81,10 @@ template<class Type>
 span<Type>::span(const unique_span<Type>& o) :
     begin_iterator(o.begin()), end_iterator(o.end()) {}
 
+template<class Type> template<class Other, class>
+span<Type>::span(const span<Other>& o) :
+    begin_iterator(o.begin()), end_iterator(o.end()) {}
+
 template<class Type>
 Type* span<Type>::begin() const {
     return begin_iterator;
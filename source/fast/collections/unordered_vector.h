@@ -58,7 +58,7 @@ private:
         handle* h;
     };
 
-    // TODO: use arrays<T, reverse_handle>
+    // TODO: use arrays<T, reverse_handle>, see slot_vector for index handles
     std::vector<T> elements;
     std::vector<reverse_handle> handles;
 };
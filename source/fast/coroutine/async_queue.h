@@ -0,0 +1,148 @@
+#ifndef ASYNC_QUEUE_H
+#define ASYNC_QUEUE_H
+
+#include <atomic>
+#include <coroutine>
+#include <utility>
+
+#include "scheduler.h"
+#include "../threading/inter_thread_queue.h"
+
+namespace fast {
+
+template<class Item>
+struct async_queue {
+    /* inter_thread_queue whose consumer is a coroutine.
+     * co_await pop() suspends the consumer while the queue is
+     * empty, the next push posts it to the scheduler. Like
+     * inter_thread_queue it has one producer and one consumer.
+     */
+
+    struct pop_awaiter {
+        async_queue& owner;
+        scheduler::entry e;
+
+        bool await_ready() const;
+        bool await_suspend(std::coroutine_handle<> handle);
+        Item await_resume();
+    };
+
+    async_queue(scheduler& resumer, int capacity = 4);
+
+    async_queue(const async_queue&) = delete;
+
+    async_queue& operator=(const async_queue&) = delete;
+
+    void push(Item&& value);
+    void push(Item const& value);
+
+    template<class... Args>
+    void emplace(Args&&... args);
+
+    // co_await for the next element
+    pop_awaiter pop();
+    // pop an element if there is one, never suspends
+    bool try_pop(Item& value);
+
+private:
+    // false if an element arrived while suspending
+    bool suspend(scheduler::entry& e);
+    // called after every push with its result
+    void published(bool had_elements);
+
+    scheduler& resumer;
+    mutable inter_thread_queue<Item> queue;
+    // suspended consumer, taken by whoever resumes it
+    std::atomic<scheduler::entry*> waiter;
+};
+
+template<class Item>
+bool async_queue<Item>::pop_awaiter::await_ready() const {
+    return owner.queue.available() > 0;
+}
+
+template<class Item>
+bool async_queue<Item>::pop_awaiter::await_suspend(
+    std::coroutine_handle<> handle
+) {
+    e.handle = handle;
+    return owner.suspend(e);
+}
+
+template<class Item>
+Item async_queue<Item>::pop_awaiter::await_resume() {
+    Item value = std::move(owner.queue.top());
+    owner.queue.pop();
+    return value;
+}
+
+template<class Item>
+async_queue<Item>::async_queue(scheduler& resumer, int capacity) :
+    resumer(resumer), queue(capacity), waiter(nullptr) {}
+
+template<class Item>
+void async_queue<Item>::push(Item&& value) {
+    published(queue.push(std::move(value)));
+}
+
+template<class Item>
+void async_queue<Item>::push(Item const& value) {
+    published(queue.push(value));
+}
+
+template<class Item> template<class... Args>
+void async_queue<Item>::emplace(Args&&... args) {
+    published(queue.emplace(std::forward<Args>(args)...));
+}
+
+template<class Item>
+typename async_queue<Item>::pop_awaiter async_queue<Item>::pop() {
+    return pop_awaiter{*this, {}};
+}
+
+template<class Item>
+bool async_queue<Item>::try_pop(Item& value) {
+    if (queue.available() == 0) {
+        return false;
+    }
+
+    value = std::move(queue.top());
+    queue.pop();
+    return true;
+}
+
+template<class Item>
+bool async_queue<Item>::suspend(scheduler::entry& e) {
+    // release, the producer writes to e once it takes it
+    waiter.store(&e, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (queue.available() > 0 && waiter.exchange(nullptr) != nullptr) {
+        return false;
+    }
+
+    // either the queue is empty or the producer took the entry
+    // and posts it
+    return true;
+}
+
+template<class Item>
+void async_queue<Item>::published(bool had_elements) {
+    // the queue loads the consumer's counter after publishing, if it
+    // still saw elements the consumer will see this one before suspending
+    if (had_elements) {
+        return;
+    }
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiter.load(std::memory_order_relaxed) != nullptr) {
+        scheduler::entry* e = waiter.exchange(nullptr);
+        if (e != nullptr) {
+            resumer.post(*e);
+        }
+    }
+}
+
+}
+
+#endif // ASYNC_QUEUE_H
@@ -0,0 +1,146 @@
+#ifndef ASYNC_SEMAPHORE_H
+#define ASYNC_SEMAPHORE_H
+
+#include <atomic>
+#include <coroutine>
+#include <mutex>
+
+#include "scheduler.h"
+
+namespace fast {
+
+struct async_semaphore {
+    /* Counting semaphore for coroutines. acquire suspends the
+     * awaiting coroutine instead of its thread, release posts
+     * waiters to the scheduler. Like semaphore the count goes
+     * negative while coroutines wait, the lock is only taken
+     * to queue or wake a waiter.
+     */
+
+    struct acquire_awaiter {
+        async_semaphore& owner;
+        scheduler::entry e;
+
+        bool await_ready() const noexcept;
+        bool await_suspend(std::coroutine_handle<> handle);
+        void await_resume() const noexcept;
+    };
+
+    async_semaphore(scheduler& resumer, int count = 0);
+
+    async_semaphore(const async_semaphore&) = delete;
+
+    async_semaphore& operator=(const async_semaphore&) = delete;
+
+    // co_await to decrement the count
+    acquire_awaiter acquire();
+    // decrement the count if it is positive, never suspends
+    bool try_acquire();
+
+    // increment the count by count, resuming up to count waiters
+    void release(int count = 1);
+
+private:
+    // false if the count was taken without suspending
+    bool suspend(scheduler::entry& e);
+
+    scheduler& resumer;
+    std::atomic_int s;
+
+    std::mutex mutex;
+    // waiters in arrival order, linked through their entries
+    scheduler::entry* first;
+    scheduler::entry* last;
+    // releases that came before their waiter was queued
+    int pending;
+};
+
+inline bool async_semaphore::acquire_awaiter::await_ready() const noexcept {
+    return owner.try_acquire();
+}
+
+inline bool async_semaphore::acquire_awaiter::await_suspend(
+    std::coroutine_handle<> handle
+) {
+    e.handle = handle;
+    return owner.suspend(e);
+}
+
+inline void async_semaphore::acquire_awaiter::await_resume() const noexcept {}
+
+inline async_semaphore::async_semaphore(scheduler& resumer, int count) :
+    resumer(resumer), s(count), first(nullptr), last(nullptr), pending(0) {}
+
+inline async_semaphore::acquire_awaiter async_semaphore::acquire() {
+    return acquire_awaiter{*this, {}};
+}
+
+inline bool async_semaphore::try_acquire() {
+    int old = s.load(std::memory_order_relaxed);
+    while (old > 0) {
+        if (s.compare_exchange_weak(
+            old, old - 1, std::memory_order_acquire, std::memory_order_relaxed
+        )) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline void async_semaphore::release(int count) {
+    int old = s.fetch_add(count, std::memory_order_release);
+    int waiting = old < 0 ? -old : 0;
+    int wake = waiting < count ? waiting : count;
+
+    // detached from the front of the waiters, still linked in order
+    scheduler::entry* woken = nullptr;
+    if (wake > 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        woken = first;
+        scheduler::entry* e = nullptr;
+        for (; wake > 0 && first != nullptr; wake--) {
+            e = first;
+            first = e->next;
+        }
+        if (e != nullptr) {
+            e->next = nullptr;
+        }
+        if (first == nullptr) {
+            last = nullptr;
+        }
+        // the rest decremented but didn't queue yet
+        pending += wake;
+    }
+
+    // the coroutine may run and end as soon as it is posted
+    while (woken != nullptr) {
+        scheduler::entry* next = woken->next;
+        resumer.post(*woken);
+        woken = next;
+    }
+}
+
+inline bool async_semaphore::suspend(scheduler::entry& e) {
+    if (s.fetch_sub(1, std::memory_order_acquire) > 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pending > 0) {
+        pending--;
+        return false;
+    }
+
+    e.next = nullptr;
+    if (last != nullptr) {
+        last->next = &e;
+    } else {
+        first = &e;
+    }
+    last = &e;
+    return true;
+}
+
+}
+
+#endif // ASYNC_SEMAPHORE_H
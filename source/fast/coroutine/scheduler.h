@@ -0,0 +1,252 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#if !defined(__cpp_impl_coroutine)
+#error "fast/coroutine needs C++20, build with CONFIG += coroutines"
+#endif
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <utility>
+
+#include "../threading/semaphore.h"
+
+namespace fast {
+
+struct task;
+
+struct scheduler {
+    /* Resumes coroutines on the thread that calls run.
+     * Coroutines are posted from any thread through an intrusive
+     * stack, the entries live in the suspended coroutine frames,
+     * so posting never allocates. The running thread sleeps on
+     * a semaphore that is only signaled while it sleeps.
+     */
+
+    struct entry {
+        std::coroutine_handle<> handle;
+        entry* next;
+    };
+
+    struct schedule_awaiter {
+        scheduler& owner;
+        entry e;
+
+        bool await_ready() const noexcept;
+        void await_suspend(std::coroutine_handle<> handle);
+        void await_resume() const noexcept;
+    };
+
+    scheduler();
+
+    scheduler(const scheduler&) = delete;
+
+    scheduler& operator=(const scheduler&) = delete;
+
+    /**
+     * @brief resume e.handle on the running thread, may be called from
+     * any thread
+     * e has to stay valid until the coroutine is resumed.
+     */
+    void post(entry& e);
+
+    // co_await to continue on the running thread
+    schedule_awaiter schedule();
+
+    // start t on the running thread, it destroys itself when done
+    void spawn(task t);
+
+    /**
+     * @brief resume the coroutines posted so far in posting order
+     * Only one thread may run a scheduler at a time.
+     * @return the number of resumed coroutines
+     */
+    std::size_t run_ready();
+
+    /**
+     * @brief resume coroutines until stop is called
+     * Coroutines that are still suspended after that are not destroyed.
+     */
+    void run();
+
+    // may be called from any thread, including a coroutine
+    void stop();
+
+private:
+    void notify();
+
+    // most recently posted first
+    std::atomic<entry*> posted;
+
+    std::atomic_bool sleeping;
+    std::atomic_bool stopped;
+    semaphore wake;
+};
+
+struct task {
+    /* Coroutine started by scheduler::spawn. Suspended until
+     * then and destroys itself when it returns.
+     */
+
+    struct promise_type {
+        scheduler::entry e;
+
+        task get_return_object() noexcept;
+        std::suspend_always initial_suspend() const noexcept;
+        std::suspend_never final_suspend() const noexcept;
+        void return_void() const noexcept;
+        void unhandled_exception() const noexcept;
+    };
+
+    task(task&& other) noexcept;
+    // destroys the coroutine if it was never spawned
+    ~task();
+
+    task& operator=(const task&) = delete;
+
+private:
+    friend struct scheduler;
+
+    task(std::coroutine_handle<promise_type> handle);
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+inline bool scheduler::schedule_awaiter::await_ready() const noexcept {
+    return false;
+}
+
+inline void scheduler::schedule_awaiter::await_suspend(
+    std::coroutine_handle<> handle
+) {
+    e.handle = handle;
+    owner.post(e);
+}
+
+inline void scheduler::schedule_awaiter::await_resume() const noexcept {}
+
+inline scheduler::scheduler() :
+    posted(nullptr), sleeping(false), stopped(false) {}
+
+inline void scheduler::post(entry& e) {
+    entry* head = posted.load(std::memory_order_relaxed);
+    do {
+        e.next = head;
+    } while (!posted.compare_exchange_weak(
+        head, &e, std::memory_order_release, std::memory_order_relaxed
+    ));
+
+    if (head == nullptr) {
+        // the running thread only sleeps on an empty stack
+        notify();
+    }
+}
+
+inline scheduler::schedule_awaiter scheduler::schedule() {
+    return schedule_awaiter{*this, {}};
+}
+
+inline void scheduler::spawn(task t) {
+    std::coroutine_handle<task::promise_type> handle =
+        std::exchange(t.handle, nullptr);
+    handle.promise().e.handle = handle;
+    post(handle.promise().e);
+}
+
+inline std::size_t scheduler::run_ready() {
+    // the whole stack at once, so there is no ABA problem
+    entry* head = posted.exchange(nullptr, std::memory_order_acquire);
+
+    entry* reversed = nullptr;
+    while (head != nullptr) {
+        entry* next = head->next;
+        head->next = reversed;
+        reversed = head;
+        head = next;
+    }
+
+    std::size_t count = 0;
+    while (reversed != nullptr) {
+        // resuming may end the frame that holds the entry
+        entry* next = reversed->next;
+        reversed->handle.resume();
+        reversed = next;
+        count++;
+    }
+    return count;
+}
+
+inline void scheduler::run() {
+    while (!stopped.load(std::memory_order_acquire)) {
+        if (run_ready() > 0) {
+            continue;
+        }
+
+        sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (
+            (posted.load(std::memory_order_relaxed) != nullptr ||
+            stopped.load(std::memory_order_relaxed)) &&
+            sleeping.exchange(false)
+        ) {
+            continue;
+        }
+
+        // either there is nothing to do or a poster took the flag
+        // and its signal has to be consumed
+        wake.wait();
+    }
+}
+
+inline void scheduler::stop() {
+    stopped.store(true);
+    notify();
+}
+
+inline void scheduler::notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (
+        sleeping.load(std::memory_order_relaxed) &&
+        sleeping.exchange(false)
+    ) {
+        wake.signal();
+    }
+}
+
+inline task task::promise_type::get_return_object() noexcept {
+    return task(std::coroutine_handle<promise_type>::from_promise(*this));
+}
+
+inline std::suspend_always
+task::promise_type::initial_suspend() const noexcept {
+    return {};
+}
+
+inline std::suspend_never task::promise_type::final_suspend() const noexcept {
+    return {};
+}
+
+inline void task::promise_type::return_void() const noexcept {}
+
+inline void task::promise_type::unhandled_exception() const noexcept {
+    std::terminate();
+}
+
+inline task::task(std::coroutine_handle<promise_type> handle) :
+    handle(handle) {}
+
+inline task::task(task&& other) noexcept :
+    handle(std::exchange(other.handle, nullptr)) {}
+
+inline task::~task() {
+    if (handle) {
+        handle.destroy();
+    }
+}
+
+}
+
+#endif // SCHEDULER_H
@@ -0,0 +1,245 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "semaphore.h"
+#include "../utility/cache_line.h"
+
+namespace fast {
+
+template<class Item>
+struct bounded_queue {
+    /* Thread-safe, fixed capacity queue for any number
+     * of producers and consumers. Each slot has a sequence
+     * number that tells whether it is ready to be written
+     * or read in the current round.
+     */
+
+    /**
+     * @param capacity The maximum number of elements, rounded up to a power
+     * of two
+     */
+    bounded_queue(std::size_t capacity);
+
+    bounded_queue(const bounded_queue&) = delete;
+
+    bounded_queue& operator=(const bounded_queue&) = delete;
+
+    /**
+     * @brief push an element if the queue is not full
+     * @return true if the element was pushed, value is unchanged otherwise
+     */
+    bool try_push(Item&& value);
+    bool try_push(Item const& value);
+
+    /**
+     * @brief pop an element if the queue is not empty
+     * @return true if an element was written to value
+     */
+    bool try_pop(Item& value);
+
+    // wait until there is space, then push
+    void push(Item&& value);
+    void push(Item const& value);
+
+    // wait until there is an element, then pop
+    void pop(Item& value);
+
+    std::size_t capacity() const;
+
+private:
+    struct cell {
+        std::atomic<std::size_t> sequence;
+        Item value;
+    };
+
+    template<class Value>
+    bool try_push_value(Value&& value);
+    template<class Value>
+    void push_value(Value&& value);
+
+    // shared by producers
+    alignas(cache_line_size) std::atomic<std::size_t> head;
+    // shared by consumers
+    alignas(cache_line_size) std::atomic<std::size_t> tail;
+
+    // read only after construction
+    alignas(cache_line_size) const std::size_t mask;
+    const std::unique_ptr<cell[]> cells;
+
+    // threads waiting in push and pop, only signaled if there are any
+    alignas(cache_line_size) std::atomic_int producers_waiting;
+    std::atomic_int consumers_waiting;
+    semaphore space, items;
+};
+
+namespace detail {
+    inline std::size_t next_power_of_two(std::size_t value) {
+        std::size_t result = 2;
+        while (result < value) {
+            result += result;
+        }
+        return result;
+    }
+}
+
+template<class Item>
+bounded_queue<Item>::bounded_queue(std::size_t capacity) :
+    head(0),
+    tail(0),
+    mask(detail::next_power_of_two(capacity) - 1),
+    cells(new cell[mask + 1]),
+    producers_waiting(0),
+    consumers_waiting(0)
+{
+    for (std::size_t i = 0; i <= mask; i++) {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template<class Item>
+bool bounded_queue<Item>::try_push(Item&& value) {
+    return try_push_value(std::move(value));
+}
+
+template<class Item>
+bool bounded_queue<Item>::try_push(Item const& value) {
+    return try_push_value(value);
+}
+
+template<class Item>
+bool bounded_queue<Item>::try_pop(Item& value) {
+    std::size_t position = tail.load(std::memory_order_relaxed);
+    cell* c;
+
+    while (true) {
+        c = &cells[position & mask];
+        std::size_t sequence = c->sequence.load(std::memory_order_acquire);
+        std::intptr_t difference =
+            std::intptr_t(sequence) - std::intptr_t(position + 1);
+
+        if (difference == 0) {
+            // slot was written in this round, try to claim it
+            if (tail.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed
+            )) {
+                break;
+            }
+        } else if (difference < 0) {
+            // empty
+            return false;
+        } else {
+            // another consumer was faster
+            position = tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    value = std::move(c->value);
+    // ready to be written in the next round
+    c->sequence.store(position + mask + 1, std::memory_order_release);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (producers_waiting.load(std::memory_order_relaxed) > 0) {
+        space.signal();
+    }
+
+    return true;
+}
+
+template<class Item>
+void bounded_queue<Item>::push(Item&& value) {
+    push_value(std::move(value));
+}
+
+template<class Item>
+void bounded_queue<Item>::push(Item const& value) {
+    push_value(value);
+}
+
+template<class Item>
+void bounded_queue<Item>::pop(Item& value) {
+    while (!try_pop(value)) {
+        consumers_waiting.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        // a producer that pushed before the increment didn't signal
+        if (try_pop(value)) {
+            consumers_waiting.fetch_sub(1);
+            return;
+        }
+
+        items.wait();
+        consumers_waiting.fetch_sub(1);
+    }
+}
+
+template<class Item>
+std::size_t bounded_queue<Item>::capacity() const {
+    return mask + 1;
+}
+
+template<class Item> template<class Value>
+bool bounded_queue<Item>::try_push_value(Value&& value) {
+    std::size_t position = head.load(std::memory_order_relaxed);
+    cell* c;
+
+    while (true) {
+        c = &cells[position & mask];
+        std::size_t sequence = c->sequence.load(std::memory_order_acquire);
+        std::intptr_t difference =
+            std::intptr_t(sequence) - std::intptr_t(position);
+
+        if (difference == 0) {
+            // slot was read in the last round, try to claim it
+            if (head.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed
+            )) {
+                break;
+            }
+        } else if (difference < 0) {
+            // full
+            return false;
+        } else {
+            // another producer was faster
+            position = head.load(std::memory_order_relaxed);
+        }
+    }
+
+    c->value = std::forward<Value>(value);
+    c->sequence.store(position + 1, std::memory_order_release);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumers_waiting.load(std::memory_order_relaxed) > 0) {
+        items.signal();
+    }
+
+    return true;
+}
+
+template<class Item> template<class Value>
+void bounded_queue<Item>::push_value(Value&& value) {
+    // try_push_value leaves value untouched on failure
+    while (!try_push_value(std::forward<Value>(value))) {
+        producers_waiting.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        // a consumer that popped before the increment didn't signal
+        if (try_push_value(std::forward<Value>(value))) {
+            producers_waiting.fetch_sub(1);
+            return;
+        }
+
+        space.wait();
+        producers_waiting.fetch_sub(1);
+    }
+}
+
+}
+
+#endif // BOUNDED_QUEUE_H
@@ -0,0 +1,405 @@
+#ifndef FAN_IN_QUEUE_H
+#define FAN_IN_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "inter_thread_queue.h"
+#include "semaphore.h"
+#include "../utility/cache_line.h"
+
+namespace fast {
+
+template<class Item>
+struct fan_in_queue {
+    /* Queue for many producers and a single consumer.
+     * Every producer gets its own inter_thread_queue lane,
+     * so producers never write to the same memory. A lane
+     * sets its bit in a shared mask only when it goes from
+     * empty to not empty, the consumer only visits lanes
+     * with a set bit, round-robin for fairness.
+     */
+
+    struct producer {
+        /**
+         * @brief push an element to the lane of this producer
+         * Only one thread may use a producer at a time.
+         */
+        void push(Item&& value);
+        void push(Item const& value);
+
+        template<class... Args>
+        void emplace(Args&&... args);
+
+        // false if the queue had no lane left, pushes are ignored then
+        bool valid() const;
+
+    private:
+        friend struct fan_in_queue;
+
+        producer(fan_in_queue* queue, std::size_t lane);
+
+        // called after every push with its result, which is false
+        // if the lane was empty
+        void published(bool had_elements);
+
+        fan_in_queue* queue;
+        std::size_t lane;
+    };
+
+    /**
+     * @param producers The maximum number of producers
+     * @param lane_capacity Initial capacity of every lane
+     */
+    fan_in_queue(std::size_t producers, int lane_capacity = 4);
+    ~fan_in_queue();
+
+    fan_in_queue(const fan_in_queue&) = delete;
+
+    fan_in_queue& operator=(const fan_in_queue&) = delete;
+
+    /**
+     * @brief register a producer, may be called from any thread
+     * At most the number of producers given on construction,
+     * after that the returned producers are not valid.
+     */
+    producer add_producer();
+
+    /**
+     * @brief pop one element, visiting lanes round-robin
+     * @return false if every lane was empty
+     */
+    bool try_pop(Item& value);
+
+    /**
+     * @brief call function(Item&) on every element available
+     * and pop them, lane by lane
+     * @return the number of elements consumed
+     */
+    template<class Function>
+    std::size_t consume_all(Function function);
+
+    // block the consumer until some lane has an element
+    void wait();
+    /**
+     * @return true if an element is available, false on timeout
+     */
+    template<class Rep, class Period>
+    bool wait_for(const std::chrono::duration<Rep, Period>& timeout);
+
+    std::size_t producers() const;
+
+private:
+    static constexpr std::size_t bits = 64;
+
+    struct alignas(cache_line_size) lane {
+        inter_thread_queue<Item> queue;
+
+        lane(int capacity);
+    };
+
+    // next lane with its bit set at or after from, false if none
+    bool find(std::size_t from, std::size_t& index) const;
+    // clear the bit of an empty lane, false if it got an element meanwhile
+    bool clear(std::size_t index);
+    bool ready() const;
+
+    // read only after construction
+    const std::size_t count;
+    const std::size_t words;
+    // lanes are aligned by hand, new ignores alignas before C++17
+    std::unique_ptr<char[]> memory;
+    lane* lanes;
+
+    // one bit per lane that may have elements
+    const std::unique_ptr<std::atomic<std::uint64_t>[]> ready_lanes;
+    alignas(cache_line_size) std::atomic<std::size_t> registered;
+
+    // consumer only
+    alignas(cache_line_size) std::size_t next;
+    std::atomic_bool waiting;
+    semaphore wake;
+};
+
+template<class Item>
+fan_in_queue<Item>::producer::producer(
+    fan_in_queue* queue, std::size_t lane
+) :
+    queue(queue), lane(lane) {}
+
+template<class Item>
+void fan_in_queue<Item>::producer::push(Item&& value) {
+    assert(valid());
+    if (valid()) {
+        published(queue->lanes[lane].queue.push(std::move(value)));
+    }
+}
+
+template<class Item>
+void fan_in_queue<Item>::producer::push(Item const& value) {
+    assert(valid());
+    if (valid()) {
+        published(queue->lanes[lane].queue.push(value));
+    }
+}
+
+template<class Item> template<class... Args>
+void fan_in_queue<Item>::producer::emplace(Args&&... args) {
+    assert(valid());
+    if (valid()) {
+        published(
+            queue->lanes[lane].queue.emplace(std::forward<Args>(args)...)
+        );
+    }
+}
+
+template<class Item>
+bool fan_in_queue<Item>::producer::valid() const {
+    return queue != nullptr;
+}
+
+template<class Item>
+void fan_in_queue<Item>::producer::published(bool had_elements) {
+    if (!had_elements) {
+        // the lane loads the consumer's counter after publishing,
+        // a consumer that cleared the bit without seeing the element
+        // has popped everything before and we saw an empty lane
+        std::uint64_t bit = std::uint64_t(1) << lane % bits;
+        queue->ready_lanes[lane / bits].fetch_or(bit);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (
+            queue->waiting.load(std::memory_order_relaxed) &&
+            queue->waiting.exchange(false)
+        ) {
+            queue->wake.signal();
+        }
+    }
+}
+
+template<class Item>
+fan_in_queue<Item>::lane::lane(int capacity) : queue(capacity) {}
+
+template<class Item>
+fan_in_queue<Item>::fan_in_queue(std::size_t producers, int lane_capacity) :
+    count(producers),
+    words((producers + bits - 1) / bits),
+    memory(new char[producers * sizeof(lane) + cache_line_size]),
+    ready_lanes(new std::atomic<std::uint64_t>[words]),
+    registered(0),
+    next(0),
+    waiting(false)
+{
+    void* start = memory.get();
+    std::size_t space = producers * sizeof(lane) + cache_line_size;
+    start = std::align(
+        cache_line_size, producers * sizeof(lane), start, space
+    );
+    lanes = static_cast<lane*>(start);
+
+    for (std::size_t i = 0; i < count; i++) {
+        new (&lanes[i]) lane(lane_capacity);
+    }
+
+    for (std::size_t i = 0; i < words; i++) {
+        ready_lanes[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+template<class Item>
+fan_in_queue<Item>::~fan_in_queue() {
+    for (std::size_t i = 0; i < count; i++) {
+        lanes[i].~lane();
+    }
+}
+
+template<class Item>
+typename fan_in_queue<Item>::producer fan_in_queue<Item>::add_producer() {
+    std::size_t index = registered.fetch_add(1, std::memory_order_relaxed);
+    if (index >= count) {
+        // every lane is taken, release builds must not index past them
+        return producer(nullptr, 0);
+    }
+    return producer(this, index);
+}
+
+template<class Item>
+bool fan_in_queue<Item>::try_pop(Item& value) {
+    std::size_t index;
+    std::size_t from = next;
+
+    while (find(from, index)) {
+        inter_thread_queue<Item>& queue = lanes[index].queue;
+        if (queue.available() > 0 || !clear(index)) {
+            value = std::move(queue.top());
+            queue.pop();
+            next = index + 1 < count ? index + 1 : 0;
+            return true;
+        }
+        from = index;
+    }
+
+    return false;
+}
+
+template<class Item> template<class Function>
+std::size_t fan_in_queue<Item>::consume_all(Function function) {
+    std::size_t consumed = 0;
+
+    for (std::size_t w = 0; w < words; w++) {
+        std::uint64_t word = ready_lanes[w].load(std::memory_order_acquire);
+
+        while (word != 0) {
+            std::size_t bit = 0;
+            while ((word >> bit & 1) == 0) {
+                bit++;
+            }
+            word &= ~(std::uint64_t(1) << bit);
+
+            std::size_t index = w * bits + bit;
+            inter_thread_queue<Item>& queue = lanes[index].queue;
+
+            // only what is there now, a busy producer can't keep
+            // the consumer away from the other lanes
+            std::size_t remaining = queue.available();
+            while (remaining > 0) {
+                span<Item> items = queue.readable();
+                std::size_t size = std::min<std::size_t>(
+                    items.end() - items.begin(), remaining
+                );
+                for (std::size_t i = 0; i < size; i++) {
+                    function(items.begin()[i]);
+                }
+                queue.pop_n(size);
+                remaining -= size;
+                consumed += size;
+            }
+
+            clear(index);
+        }
+    }
+
+    return consumed;
+}
+
+template<class Item>
+void fan_in_queue<Item>::wait() {
+    if (ready()) {
+        return;
+    }
+
+    waiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (ready() && waiting.exchange(false)) {
+        return;
+    }
+
+    // either nothing was ready or a producer took the flag
+    // and its signal has to be consumed
+    wake.wait();
+}
+
+template<class Item> template<class Rep, class Period>
+bool fan_in_queue<Item>::wait_for(
+    const std::chrono::duration<Rep, Period>& timeout
+) {
+    if (ready()) {
+        return true;
+    }
+
+    waiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (ready() && waiting.exchange(false)) {
+        return true;
+    }
+
+    if (wake.wait_for(timeout)) {
+        return true;
+    }
+
+    if (!waiting.exchange(false)) {
+        // a producer took the flag just now, its signal is on the way
+        wake.wait();
+        return true;
+    }
+
+    return ready();
+}
+
+template<class Item>
+std::size_t fan_in_queue<Item>::producers() const {
+    return count;
+}
+
+template<class Item>
+bool fan_in_queue<Item>::find(std::size_t from, std::size_t& index) const {
+    // from the start position to the end, then wrap around
+    for (std::size_t round = 0; round < 2; round++) {
+        std::size_t first = round == 0 ? from : 0;
+        std::size_t last = round == 0 ? count : from;
+
+        for (std::size_t i = first; i < last; ) {
+            std::uint64_t word =
+                ready_lanes[i / bits].load(std::memory_order_acquire);
+            word >>= i % bits;
+
+            if (word == 0) {
+                // skip the rest of the word
+                i += bits - i % bits;
+                continue;
+            }
+
+            while ((word & 1) == 0) {
+                word >>= 1;
+                i++;
+            }
+
+            if (i < last) {
+                index = i;
+                return true;
+            }
+            break;
+        }
+    }
+
+    return false;
+}
+
+template<class Item>
+bool fan_in_queue<Item>::clear(std::size_t index) {
+    std::uint64_t bit = std::uint64_t(1) << index % bits;
+    ready_lanes[index / bits].fetch_and(~bit);
+
+    // pairs with the fence of the lane's push, either we see the
+    // element or the producer sees an empty lane and sets the bit again
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (lanes[index].queue.available() > 0) {
+        ready_lanes[index / bits].fetch_or(bit);
+        return false;
+    }
+
+    return true;
+}
+
+template<class Item>
+bool fan_in_queue<Item>::ready() const {
+    for (std::size_t w = 0; w < words; w++) {
+        if (ready_lanes[w].load(std::memory_order_relaxed) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+#endif // FAN_IN_QUEUE_H
@@ -3,13 +3,25 @@
 
 #include <atomic>
 #include <cassert>
+#include <cstddef>
 #include <utility>
 #include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <iterator>
+#include <new>
+#include <type_traits>
+
+#include "../collections/span.h"
+#include "../utility/cache_line.h"
+#include "../utility/contention.h"
 
 namespace fast {
 
 template<class Item>
-struct inter_thread_queue {
+struct inter_thread_queue : private contention_counters {
     /* Thread-safe, dynamically growing queue.
      * When an element has to be inserted when the
      * available space is not sufficient alocate more
@@ -28,75 +40,201 @@ struct inter_thread_queue {
     bool push(Item&& value);
     bool push(Item const& value);
 
+    /**
+     * @brief construct an element in place at the end of the queue
+     * @return true if the queue was not empty, false if it was
+     */
+    template<class... Args>
+    bool emplace(Args&&... args);
+
+    /**
+     * @brief move all values to the queue, publishing them at once
+     * @return true if the queue was not empty, false if it was
+     */
+    bool push_n(span<Item> values);
+
     /**
      * @brief pop an element off the queue
      * @return true if the queue has more elements
      */
     bool pop();
 
+    /**
+     * @brief pop count elements with a single update of the shared counter
+     * @return true if the queue has more elements
+     */
+    bool pop_n(std::size_t count);
+
     Item &top();
 
+    /**
+     * @return the elements that are available in the block of top,
+     * can be processed in place and then popped with pop_n
+     */
+    span<Item> readable();
+
+    // number of elements visible to the consumer
     int available();
 
+    /**
+     * @brief block the consumer until an element is available
+     * Producers only make a system call while the consumer is waiting.
+     */
+    void wait();
+    /**
+     * @return true if an element is available, false on timeout
+     */
+    template<class Rep, class Period>
+    bool wait_for(const std::chrono::duration<Rep, Period>& timeout);
+
+    // wait for an element, move it to value and pop it
+    void wait_pop(Item& value);
+    template<class Rep, class Period>
+    bool wait_pop_for(
+        Item& value, const std::chrono::duration<Rep, Period>& timeout
+    );
+
+    /**
+     * @brief free the blocks the consumer is done with
+     * May only be called by the producer. Later growth starts again
+     * from the remaining capacity.
+     * @return the number of freed blocks
+     */
+    std::size_t trim();
+
+    struct statistics {
+        // memory held by blocks, including their elements
+        std::size_t allocated_bytes;
+        std::size_t blocks;
+        // largest number of elements the producer has seen in the queue
+        std::size_t peak_size;
+        // number of blocks allocated because the queue was full
+        std::size_t grow_events;
+    };
+
+    // may be called from any thread, values are maintained by the producer
+    statistics stats() const;
+
+    /**
+     * @return the counters enabled by FAST_CONTENTION_COUNTERS,
+     * all zero otherwise, there are no compare exchanges or swaps
+     */
+    contention_snapshot contention() const;
+
 private:
-    /* TODO: instead of size store the number of items
-     * written and read. This can be done using only
-     * load and store which are much cheaper.
-     * It's easily possible for the using class to
-     * determine whether it should call wait/notify.
-     * Just have an atomic_bool that's set before every
-     * wait and cleared after every notify.
+    // an empty base unless enabled, so disabled counters take no space
+    contention_counters& counters();
+    const contention_counters& counters() const;
+
+    /* Instead of a shared size the producer and the consumer
+     * each publish the number of elements they pushed or popped
+     * with a plain store. Each side keeps a copy of the other's
+     * counter and only loads it again if the copy is not enough
+     * to make a decision.
      */
 
     struct block {
+        typedef typename std::aligned_storage<
+            sizeof(Item), alignof(Item)
+        >::type storage;
+
         const unsigned int size;
-        const std::unique_ptr<Item> items;
+        // elements are constructed by push and destroyed by pop
+        const std::unique_ptr<storage[]> items;
         block *next; // may only be written during insertion
+        // number of elements pushed when the producer left this block
+        std::size_t end;
 
         block(unsigned int size, block *next = nullptr);
         ~block() = default;
+
+        Item* item(unsigned int index);
     };
 
-    // number of elements
-    std::atomic_uint size;
-    // number of blocks with elements
-    std::atomic_uint block_size;
+    // moves head to a block with free space
+    void next_block(std::size_t count);
+    block* allocate(unsigned int size, block* next);
+    void deallocate(block* b);
+    // stores the new number of pushed elements and notifies the consumer
+    bool publish(std::size_t count, std::size_t new_count);
+    // makes sure read points into the block of the next element
+    void advance();
+    // whether the consumer can pop, refreshes pushed_cache if needed
+    bool ready();
+
+    // written by the producer
+    alignas(cache_line_size) std::atomic<std::size_t> pushed;
+    // written by the consumer
+    alignas(cache_line_size) std::atomic<std::size_t> popped;
 
     // producer variables:
     // number of elemts that can be stored without allocatation
-    unsigned int capacity;
-    // number of blocks allocated
-    unsigned int block_capacity;
+    alignas(cache_line_size) unsigned int capacity;
     // index to write next in head Block
     unsigned int write;
     block *head;
+    // last seen value of popped
+    std::size_t popped_cache;
+    // only written by the producer
+    std::atomic<std::size_t> allocated_bytes;
+    std::atomic<std::size_t> block_count;
+    std::atomic<std::size_t> peak_size;
+    std::atomic<std::size_t> grow_events;
 
     // consumer variables:
     // index to read next in tail Block
-    unsigned int read;
+    alignas(cache_line_size) unsigned int read;
     block *tail;
+    // last seen value of pushed
+    std::size_t pushed_cache;
+
+    // set while the consumer is blocked, only then producers notify
+    alignas(cache_line_size) std::atomic_bool waiting;
+    std::mutex mutex;
+    std::condition_variable condition;
 };
 
 template<class Item>
 inter_thread_queue<Item>::block::block(
     unsigned int size, inter_thread_queue<Item>::block *next
 ) :
-    size(size), items(new Item[size]), next(next ? next : this) {}
+    size(size), items(new storage[size]), next(next ? next : this), end(0) {}
+
+template<class Item>
+Item* inter_thread_queue<Item>::block::item(unsigned int index) {
+    return reinterpret_cast<Item*>(&items[index]);
+}
 
 template<class Item>
 inter_thread_queue<Item>::inter_thread_queue(int capacity) :
-    size(0),
-    block_size(1),
+    pushed(0),
+    popped(0),
     capacity(capacity),
-    block_capacity(1),
     write(0),
-    head(new block(capacity)),
+    head(nullptr),
+    popped_cache(0),
+    allocated_bytes(0),
+    block_count(0),
+    peak_size(0),
+    grow_events(0),
     read(0),
-    tail(head) {
+    tail(nullptr),
+    pushed_cache(0),
+    waiting(false) {
+    head = allocate(capacity, nullptr);
+    tail = head;
 }
 
 template<class Item>
 inter_thread_queue<Item>::~inter_thread_queue() {
+    // destroy elements that were never popped
+    std::size_t remaining =
+        pushed.load(std::memory_order_relaxed) -
+        popped.load(std::memory_order_relaxed);
+    if (remaining > 0) {
+        pop_n(remaining);
+    }
+
     if (head != nullptr) {
         block *current = head;
         do {
@@ -109,54 +247,315 @@ inter_thread_queue<Item>::~inter_thread_queue() {
 
 template<class Item>
 bool inter_thread_queue<Item>::push(Item &&value) {
+    return emplace(std::move(value));
+}
+
+template<class Item>
+bool inter_thread_queue<Item>::push(Item const& value) {
+    return emplace(value);
+}
+
+template<class Item> template<class... Args>
+bool inter_thread_queue<Item>::emplace(Args&&... args) {
+    std::size_t count = pushed.load(std::memory_order_relaxed);
+
     if (write >= head->size) {
         // no space left in this block
-        if (block_size.load(std::memory_order_relaxed) >= block_capacity) {
-            // the next block is not available
-            // double the capacity
-            head->next = new block(capacity, head->next);
-            capacity += capacity;
-            block_capacity++;
-        }
-
-        write = 0;
-        head = head->next;
-        block_size.fetch_add(1, std::memory_order_relaxed);
+        next_block(count);
     }
 
-    head->items.get()[write] = std::move(value);
-    bool empty = size.fetch_add(1, std::memory_order_release) == 0;
+    new (head->item(write)) Item(std::forward<Args>(args)...);
     write++;
 
-    return !empty;
+    return publish(count, count + 1);
 }
 
 template<class Item>
-bool inter_thread_queue<Item>::push(Item const& value) {
-    int copy = value;
-    return push(std::move(copy));
+bool inter_thread_queue<Item>::push_n(span<Item> values) {
+    std::size_t count = pushed.load(std::memory_order_relaxed);
+    Item* begin = values.begin();
+
+    while (begin != values.end()) {
+        if (write >= head->size) {
+            next_block(count + (begin - values.begin()));
+        }
+
+        std::size_t n = std::min<std::size_t>(
+            head->size - write, values.end() - begin
+        );
+        std::uninitialized_copy(
+            std::make_move_iterator(begin), std::make_move_iterator(begin + n),
+            head->item(write)
+        );
+        write += n;
+        begin += n;
+    }
+
+    return publish(count, count + (values.end() - values.begin()));
 }
 
 template<class Item>
 bool inter_thread_queue<Item>::pop() {
-    assert(size.load() > 0);
+    return pop_n(1);
+}
 
-    bool last = size.fetch_sub(1, std::memory_order_acquire) == 1;
-    read++;
+template<class Item>
+bool inter_thread_queue<Item>::pop_n(std::size_t n) {
+    std::size_t count = popped.load(std::memory_order_relaxed) + n;
+    assert(count <= pushed.load());
 
-    if (read >= tail->size) {
-        // done with current block
-        tail = tail->next;
-        read = 0;
-        block_size.fetch_sub(1, std::memory_order_relaxed);
+    while (n > 0) {
+        advance();
+        std::size_t step = std::min<std::size_t>(tail->size - read, n);
+        for (std::size_t i = 0; i < step; i++) {
+            tail->item(read + i)->~Item();
+        }
+        read += step;
+        n -= step;
     }
+    popped.store(count, std::memory_order_release);
 
-    return !last;
+    if (count < pushed_cache) {
+        return true;
+    }
+    pushed_cache = pushed.load(std::memory_order_acquire);
+    return count < pushed_cache;
 }
 
 template<class Item>
 Item &inter_thread_queue<Item>::top() {
-    return tail->items.get()[read];
+    advance();
+    return *tail->item(read);
+}
+
+template<class Item>
+span<Item> inter_thread_queue<Item>::readable() {
+    if (!ready()) {
+        counters().empty_poll();
+        return span<Item>();
+    }
+
+    advance();
+    std::size_t count = std::min<std::size_t>(
+        tail->size - read, pushed_cache - popped.load(std::memory_order_relaxed)
+    );
+    Item* begin = tail->item(read);
+    return span<Item>(begin, begin + count);
+}
+
+template<class Item>
+std::size_t inter_thread_queue<Item>::trim() {
+    popped_cache = popped.load(std::memory_order_acquire);
+
+    // blocks after head that the consumer popped past are empty
+    // and won't be read again, the consumer's block ends the run
+    std::size_t freed = 0;
+    block *next = head->next;
+    while (next != head && popped_cache > next->end) {
+        block *following = next->next;
+        capacity -= next->size;
+        deallocate(next);
+        next = following;
+        freed++;
+    }
+    head->next = next;
+
+    return freed;
+}
+
+template<class Item>
+typename inter_thread_queue<Item>::statistics
+inter_thread_queue<Item>::stats() const {
+    return {
+        allocated_bytes.load(std::memory_order_relaxed),
+        block_count.load(std::memory_order_relaxed),
+        peak_size.load(std::memory_order_relaxed),
+        grow_events.load(std::memory_order_relaxed)
+    };
+}
+
+template<class Item>
+contention_counters& inter_thread_queue<Item>::counters() {
+    return *this;
+}
+
+template<class Item>
+const contention_counters& inter_thread_queue<Item>::counters() const {
+    return *this;
+}
+
+template<class Item>
+contention_snapshot inter_thread_queue<Item>::contention() const {
+    return counters().snapshot();
+}
+
+template<class Item>
+int inter_thread_queue<Item>::available() {
+    pushed_cache = pushed.load(std::memory_order_acquire);
+    int count = pushed_cache - popped.load(std::memory_order_relaxed);
+    if (count == 0) {
+        counters().empty_poll();
+    }
+    return count;
+}
+
+template<class Item>
+void inter_thread_queue<Item>::wait() {
+    if (ready()) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    waiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    condition.wait(lock, [this]{ return ready(); });
+    waiting.store(false, std::memory_order_relaxed);
+}
+
+template<class Item> template<class Rep, class Period>
+bool inter_thread_queue<Item>::wait_for(
+    const std::chrono::duration<Rep, Period>& timeout
+) {
+    if (ready()) {
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    waiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool result =
+        condition.wait_for(lock, timeout, [this]{ return ready(); });
+    waiting.store(false, std::memory_order_relaxed);
+    return result;
+}
+
+template<class Item>
+void inter_thread_queue<Item>::wait_pop(Item& value) {
+    wait();
+    value = std::move(top());
+    pop();
+}
+
+template<class Item> template<class Rep, class Period>
+bool inter_thread_queue<Item>::wait_pop_for(
+    Item& value, const std::chrono::duration<Rep, Period>& timeout
+) {
+    if (!wait_for(timeout)) {
+        return false;
+    }
+    value = std::move(top());
+    pop();
+    return true;
+}
+
+template<class Item>
+void inter_thread_queue<Item>::next_block(std::size_t count) {
+    head->end = count;
+    block *next = head->next;
+
+    // the consumer stays at the end of a block until the next
+    // element is available, so next is free once it popped past it
+    if (popped_cache <= next->end) {
+        popped_cache = popped.load(std::memory_order_acquire);
+    }
+
+    if (popped_cache <= next->end) {
+        // the next block is not available
+        // double the capacity
+        head->next = allocate(capacity, next);
+        capacity += capacity;
+        counters().block_allocation();
+        grow_events.store(
+            grow_events.load(std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed
+        );
+    }
+
+    write = 0;
+    head = head->next;
+}
+
+template<class Item>
+bool inter_thread_queue<Item>::publish(
+    std::size_t count, std::size_t new_count
+) {
+    pushed.store(new_count, std::memory_order_release);
+
+    // either the consumer sees the new count or this sees waiting
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting.load(std::memory_order_relaxed)) {
+        {
+            // the consumer is either before its check or in wait
+            std::lock_guard<std::mutex> lock(mutex);
+        }
+        condition.notify_one();
+    }
+
+    bool empty = popped_cache == count;
+    if (!empty) {
+        // the consumer can't have popped more than was pushed,
+        // otherwise the copy isn't enough
+        popped_cache = popped.load(std::memory_order_acquire);
+        empty = popped_cache == count;
+    }
+
+    std::size_t size = new_count - popped_cache;
+    if (size > peak_size.load(std::memory_order_relaxed)) {
+        peak_size.store(size, std::memory_order_relaxed);
+        counters().depth(size);
+    }
+
+    return !empty;
+}
+
+template<class Item>
+typename inter_thread_queue<Item>::block*
+inter_thread_queue<Item>::allocate(unsigned int size, block* next) {
+    block* b = new block(size, next);
+    allocated_bytes.store(
+        allocated_bytes.load(std::memory_order_relaxed) +
+        sizeof(block) + size * sizeof(Item),
+        std::memory_order_relaxed
+    );
+    block_count.store(
+        block_count.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed
+    );
+    return b;
+}
+
+template<class Item>
+void inter_thread_queue<Item>::deallocate(block* b) {
+    allocated_bytes.store(
+        allocated_bytes.load(std::memory_order_relaxed) -
+        sizeof(block) - b->size * sizeof(Item),
+        std::memory_order_relaxed
+    );
+    block_count.store(
+        block_count.load(std::memory_order_relaxed) - 1,
+        std::memory_order_relaxed
+    );
+    delete b;
+}
+
+template<class Item>
+bool inter_thread_queue<Item>::ready() {
+    std::size_t count = popped.load(std::memory_order_relaxed);
+    if (count < pushed_cache) {
+        return true;
+    }
+    pushed_cache = pushed.load(std::memory_order_acquire);
+    return count < pushed_cache;
+}
+
+template<class Item>
+void inter_thread_queue<Item>::advance() {
+    if (read >= tail->size) {
+        // done with current block
+        // next is final since the producer already wrote past tail
+        tail = tail->next;
+        read = 0;
+    }
 }
 
 }
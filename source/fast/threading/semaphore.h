@@ -1,46 +1,279 @@
 #ifndef SEMAPHORE_H
 #define SEMAPHORE_H
 
-#include <mutex>
-#include <condition_variable>
+#include <atomic>
 #include <chrono>
 
+#ifdef __linux__
+#include <cerrno>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
 namespace fast {
 
+namespace detail {
+    /* Counts wakeups for parked threads. Only used by semaphore
+     * once a thread has decided to sleep, so it doesn't need to be fast.
+     */
+    struct parker {
+        parker();
+
+        // consume a wakeup, sleep until there is one
+        void wait();
+        // false if the deadline passed without a wakeup
+        bool wait_until(std::chrono::steady_clock::time_point deadline);
+        void signal(int count);
+
+    private:
+        bool try_consume();
+
+#ifdef __linux__
+        void sleep(const timespec* timeout);
+
+        // futex word
+        std::atomic_int wakeups;
+#else
+        int wakeups;
+        std::mutex mutex;
+        std::condition_variable condition;
+#endif
+    };
+}
+
 struct semaphore {
+    /* Counting semaphore. The count goes negative while threads
+     * wait, so signal only has to wake someone if it was negative.
+     * Without contention, wait and signal are a single atomic
+     * operation each. A waiter spins for a while before parking.
+     */
+
     semaphore(int s = 0);
 
-    void signal();
+    semaphore(const semaphore&) = delete;
+
+    semaphore& operator=(const semaphore&) = delete;
+
+    // increment the count by count, waking up to count waiters
+    void signal(int count = 1);
     void wait();
-    void wait_for(int milliseconds);
+    // decrement the count if it is positive, never blocks
+    bool try_wait();
+
+    /**
+     * @brief wait until the count is positive or timeout passed
+     * @return true if the count was decremented
+     */
+    bool wait_for(int milliseconds);
+    template<class Rep, class Period>
+    bool wait_for(const std::chrono::duration<Rep, Period>& timeout);
 
 private:
-    int s;
+    // attempts of try_wait before parking
+    static constexpr int spin_limit = 128;
+
+    bool spin();
 
-    std::mutex mutex;
-    std::condition_variable condition;
+    std::atomic_int s;
+    detail::parker waiters;
 };
 
-inline semaphore::semaphore(int s) : s(s) { }
+namespace detail {
+#ifdef __linux__
+    inline parker::parker() : wakeups(0) {}
+
+    inline void parker::wait() {
+        while (!try_consume()) {
+            sleep(nullptr);
+        }
+    }
+
+    inline bool parker::wait_until(
+        std::chrono::steady_clock::time_point deadline
+    ) {
+        while (!try_consume()) {
+            auto remaining = deadline - std::chrono::steady_clock::now();
+            if (remaining <= std::chrono::steady_clock::duration::zero()) {
+                return false;
+            }
+
+            auto seconds =
+                std::chrono::duration_cast<std::chrono::seconds>(remaining);
+            timespec timeout;
+            timeout.tv_sec = static_cast<time_t>(seconds.count());
+            timeout.tv_nsec = static_cast<long>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    remaining - seconds
+                ).count()
+            );
+            sleep(&timeout);
+        }
+        return true;
+    }
+
+    inline void parker::signal(int count) {
+        wakeups.fetch_add(count, std::memory_order_release);
+        syscall(
+            SYS_futex, reinterpret_cast<int*>(&wakeups), FUTEX_WAKE_PRIVATE,
+            count, nullptr, nullptr, 0
+        );
+    }
+
+    inline void parker::sleep(const timespec* timeout) {
+        static_assert(
+            sizeof(std::atomic_int) == sizeof(int),
+            "the futex word has to be a plain int"
+        );
+        // returns immediately if a wakeup arrived since try_consume,
+        // spurious returns are handled by the callers
+        syscall(
+            SYS_futex, reinterpret_cast<int*>(&wakeups), FUTEX_WAIT_PRIVATE,
+            0, timeout, nullptr, 0
+        );
+    }
+
+    inline bool parker::try_consume() {
+        int w = wakeups.load(std::memory_order_relaxed);
+        while (w > 0) {
+            if (wakeups.compare_exchange_weak(
+                w, w - 1, std::memory_order_acquire, std::memory_order_relaxed
+            )) {
+                return true;
+            }
+        }
+        return false;
+    }
+#else
+    inline parker::parker() : wakeups(0) {}
+
+    inline void parker::wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this]{ return wakeups > 0; });
+        wakeups--;
+    }
 
-inline void semaphore::signal() {
-    {
+    inline bool parker::wait_until(
+        std::chrono::steady_clock::time_point deadline
+    ) {
         std::unique_lock<std::mutex> lock(mutex);
-        s++;
+        if (!condition.wait_until(lock, deadline, [this]{
+            return wakeups > 0;
+        })) {
+            return false;
+        }
+        wakeups--;
+        return true;
+    }
+
+    inline void parker::signal(int count) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeups += count;
+        }
+
+        if (count == 1) {
+            condition.notify_one();
+        } else {
+            condition.notify_all();
+        }
+    }
+#endif
+
+    inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+}
+
+inline semaphore::semaphore(int s) : s(s) { }
+
+inline void semaphore::signal(int count) {
+    int old = s.fetch_add(count, std::memory_order_release);
+    // -old threads are waiting or about to
+    int waiting = old < 0 ? -old : 0;
+    int wake = waiting < count ? waiting : count;
+    if (wake > 0) {
+        waiters.signal(wake);
     }
-    condition.notify_one();
 }
 
 inline void semaphore::wait() {
-    std::unique_lock<std::mutex> lock(mutex);
-    condition.wait(lock, [&]{return s != 0;});
-    s--;
+    if (spin()) {
+        return;
+    }
+
+    if (s.fetch_sub(1, std::memory_order_acquire) > 0) {
+        return;
+    }
+    waiters.wait();
+}
+
+inline bool semaphore::try_wait() {
+    int old = s.load(std::memory_order_relaxed);
+    while (old > 0) {
+        if (s.compare_exchange_weak(
+            old, old - 1, std::memory_order_acquire, std::memory_order_relaxed
+        )) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline bool semaphore::wait_for(int milliseconds) {
+    return wait_for(std::chrono::milliseconds(milliseconds));
 }
 
-inline void semaphore::wait_for(int milliseconds) {
-    std::unique_lock<std::mutex> lock(mutex);
-    condition.wait_for(lock, std::chrono::milliseconds(milliseconds), [&]{return s != 0;});
-    s--;
+template<class Rep, class Period>
+bool semaphore::wait_for(const std::chrono::duration<Rep, Period>& timeout) {
+    auto deadline = std::chrono::steady_clock::now() +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            timeout
+        );
+
+    if (spin()) {
+        return true;
+    }
+
+    if (s.fetch_sub(1, std::memory_order_acquire) > 0) {
+        return true;
+    }
+
+    if (waiters.wait_until(deadline)) {
+        return true;
+    }
+
+    // timed out, give the decrement back unless a signal already
+    // counted us, then its wakeup is on the way and has to be consumed
+    int old = s.load(std::memory_order_relaxed);
+    while (true) {
+        if (old >= 0) {
+            waiters.wait();
+            return true;
+        }
+
+        if (s.compare_exchange_weak(
+            old, old + 1, std::memory_order_relaxed
+        )) {
+            return false;
+        }
+    }
+}
+
+inline bool semaphore::spin() {
+    for (int i = 0; i < spin_limit; i++) {
+        if (try_wait()) {
+            return true;
+        }
+        detail::cpu_relax();
+    }
+    return false;
 }
 
 }
@@ -0,0 +1,293 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "bounded_queue.h"
+#include "semaphore.h"
+#include "work_stealing_deque.h"
+#include "../utility/cache_line.h"
+
+namespace fast {
+
+struct thread_pool {
+    /* Work-stealing executor. Every worker owns a deque, tasks
+     * submitted by a worker go to its own deque and are taken
+     * newest first. Idle workers steal the oldest task of another
+     * worker. Tasks from other threads go through a shared
+     * injection queue. Workers that find nothing park on a
+     * semaphore, which is only signaled while someone sleeps.
+     */
+
+    /**
+     * @param threads Number of workers, 0 uses one per hardware thread
+     * @param injection_capacity Tasks from outside the pool that can be queued
+     * before submit blocks
+     */
+    thread_pool(
+        unsigned int threads = 0, std::size_t injection_capacity = 1024
+    );
+    // runs the remaining tasks, then joins the workers
+    ~thread_pool();
+
+    thread_pool(const thread_pool&) = delete;
+
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    // run function on one of the workers
+    template<class Function>
+    void submit(Function&& function);
+
+    /**
+     * @brief call function(i) for every i in [begin, end) and wait for it
+     * The calling thread runs tasks of the pool while waiting, so this
+     * may be called from inside a task.
+     * @param grain Indices per task, 0 picks about four tasks per worker
+     */
+    template<class Function>
+    void parallel_for(
+        std::size_t begin, std::size_t end, Function function,
+        std::size_t grain = 0
+    );
+
+    unsigned int size() const;
+
+private:
+    using task = std::function<void()>;
+
+    struct worker {
+        work_stealing_deque<task*> tasks;
+        std::thread thread;
+    };
+
+    // failed attempts to find a task before a worker sleeps
+    static constexpr unsigned int spin_limit = 64;
+
+    // index of the calling thread or size() if it isn't one of ours
+    unsigned int current() const;
+
+    void schedule(task* t);
+    // run one task from anywhere, false if none was found
+    bool run_one(unsigned int index);
+    bool find(unsigned int index, task*& t);
+    bool has_work() const;
+    void work(unsigned int index);
+
+    std::vector<std::unique_ptr<worker>> workers;
+
+    bounded_queue<task*> injection;
+    // tasks in injection, lets idle workers check it without popping
+    alignas(cache_line_size) std::atomic<std::size_t> injected;
+
+    alignas(cache_line_size) std::atomic<unsigned int> sleeping;
+    std::atomic_bool stopping;
+    semaphore wake;
+};
+
+namespace detail {
+    struct thread_pool_worker {
+        const thread_pool* pool;
+        unsigned int index;
+    };
+
+    inline thread_pool_worker& current_thread_pool_worker() {
+        static thread_local thread_pool_worker worker{nullptr, 0};
+        return worker;
+    }
+}
+
+inline thread_pool::thread_pool(
+    unsigned int threads, std::size_t injection_capacity
+) :
+    injection(injection_capacity), injected(0), sleeping(0), stopping(false)
+{
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // every deque has to exist before any worker starts stealing
+    for (unsigned int i = 0; i < threads; i++) {
+        workers.emplace_back(new worker());
+    }
+
+    for (unsigned int i = 0; i < threads; i++) {
+        workers[i]->thread = std::thread([this, i]() {
+            work(i);
+        });
+    }
+}
+
+inline thread_pool::~thread_pool() {
+    stopping.store(true);
+    wake.signal(static_cast<int>(workers.size()));
+
+    for (auto& w : workers) {
+        w->thread.join();
+    }
+}
+
+template<class Function>
+void thread_pool::submit(Function&& function) {
+    schedule(new task(std::forward<Function>(function)));
+}
+
+template<class Function>
+void thread_pool::parallel_for(
+    std::size_t begin, std::size_t end, Function function, std::size_t grain
+) {
+    if (begin >= end) {
+        return;
+    }
+
+    std::size_t count = end - begin;
+    if (grain == 0) {
+        grain = std::max<std::size_t>(1, count / (4 * workers.size()));
+    }
+
+    std::size_t tasks = (count + grain - 1) / grain;
+    std::atomic<std::size_t> remaining(tasks);
+
+    // the last chunk is run by the caller
+    for (std::size_t i = 0; i + 1 < tasks; i++) {
+        std::size_t first = begin + i * grain;
+        std::size_t last = std::min(end, first + grain);
+        schedule(new task([&function, &remaining, first, last]() {
+            for (std::size_t j = first; j < last; j++) {
+                function(j);
+            }
+            remaining.fetch_sub(1, std::memory_order_release);
+        }));
+    }
+
+    for (std::size_t j = begin + (tasks - 1) * grain; j < end; j++) {
+        function(j);
+    }
+    remaining.fetch_sub(1, std::memory_order_release);
+
+    unsigned int index = current();
+    while (remaining.load(std::memory_order_acquire) != 0) {
+        if (!run_one(index)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+inline unsigned int thread_pool::size() const {
+    return static_cast<unsigned int>(workers.size());
+}
+
+inline unsigned int thread_pool::current() const {
+    detail::thread_pool_worker& w = detail::current_thread_pool_worker();
+    return w.pool == this ? w.index : size();
+}
+
+inline void thread_pool::schedule(task* t) {
+    unsigned int index = current();
+    if (index < size()) {
+        workers[index]->tasks.push(t);
+    } else {
+        // counted first, so the count never drops below zero
+        injected.fetch_add(1);
+        injection.push(t);
+    }
+
+    // pairs with the fence in work, either the sleeper sees the task
+    // or we see the sleeper
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed) > 0) {
+        wake.signal();
+    }
+}
+
+inline bool thread_pool::run_one(unsigned int index) {
+    task* t;
+    if (!find(index, t)) {
+        return false;
+    }
+
+    (*t)();
+    delete t;
+    return true;
+}
+
+inline bool thread_pool::find(unsigned int index, task*& t) {
+    if (index < size() && workers[index]->tasks.take(t)) {
+        return true;
+    }
+
+    if (injection.try_pop(t)) {
+        injected.fetch_sub(1);
+        return true;
+    }
+
+    // start after ourselves so thieves spread over the victims
+    for (unsigned int i = 1; i <= size(); i++) {
+        unsigned int victim = (index + i) % size();
+        if (victim != index && workers[victim]->tasks.steal(t)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline bool thread_pool::has_work() const {
+    if (injected.load(std::memory_order_relaxed) > 0) {
+        return true;
+    }
+
+    for (auto& w : workers) {
+        if (!w->tasks.empty()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline void thread_pool::work(unsigned int index) {
+    detail::current_thread_pool_worker() = {this, index};
+    unsigned int idle = 0;
+
+    while (true) {
+        if (run_one(index)) {
+            idle = 0;
+            continue;
+        }
+
+        if (++idle < spin_limit) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        sleeping.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        // a task scheduled before the increment didn't signal
+        if (has_work()) {
+            sleeping.fetch_sub(1);
+            idle = 0;
+            continue;
+        }
+
+        if (stopping.load()) {
+            sleeping.fetch_sub(1);
+            break;
+        }
+
+        wake.wait();
+        sleeping.fetch_sub(1);
+        idle = 0;
+    }
+}
+
+}
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,189 @@
+#ifndef WORK_STEALING_DEQUE_H
+#define WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "../utility/cache_line.h"
+
+namespace fast {
+
+template<class Item>
+struct work_stealing_deque {
+    /* Chase-Lev deque. The owning thread pushes and takes
+     * at the bottom, any other thread may steal from the top.
+     * Items are copied through atomics, so they have to be
+     * trivially copyable, usually pointers to tasks.
+     */
+
+    static_assert(
+        std::is_trivially_copyable<Item>::value,
+        "items are read concurrently and have to be trivially copyable"
+    );
+
+    work_stealing_deque(std::size_t capacity = 64);
+
+    work_stealing_deque(const work_stealing_deque&) = delete;
+
+    work_stealing_deque& operator=(const work_stealing_deque&) = delete;
+
+    // owner only
+    void push(Item item);
+    /**
+     * @brief take the most recently pushed item, owner only
+     * @return false if the deque was empty
+     */
+    bool take(Item& item);
+
+    /**
+     * @brief take the least recently pushed item, any thread
+     * @return false if the deque was empty or another thread was faster
+     */
+    bool steal(Item& item);
+
+    // may be outdated by the time it returns
+    bool empty() const;
+
+private:
+    struct array {
+        const std::int64_t mask;
+        const std::unique_ptr<std::atomic<Item>[]> items;
+
+        array(std::int64_t capacity);
+
+        Item get(std::int64_t index) const;
+        void put(std::int64_t index, Item item);
+    };
+
+    array* grow(array* a, std::int64_t bottom, std::int64_t top);
+
+    // padded instead of aligned, deques are allocated with new
+    // and over-aligned new needs C++17
+
+    // next item to steal
+    std::atomic<std::int64_t> top;
+    char top_padding[cache_line_size];
+    // next free slot
+    std::atomic<std::int64_t> bottom;
+    std::atomic<array*> items;
+    // arrays replaced by grow may still be read by thieves,
+    // they are kept until destruction
+    std::vector<std::unique_ptr<array>> arrays;
+};
+
+template<class Item>
+work_stealing_deque<Item>::array::array(std::int64_t capacity) :
+    mask(capacity - 1), items(new std::atomic<Item>[capacity]) {}
+
+template<class Item>
+Item work_stealing_deque<Item>::array::get(std::int64_t index) const {
+    return items[index & mask].load(std::memory_order_relaxed);
+}
+
+template<class Item>
+void work_stealing_deque<Item>::array::put(std::int64_t index, Item item) {
+    items[index & mask].store(item, std::memory_order_relaxed);
+}
+
+template<class Item>
+work_stealing_deque<Item>::work_stealing_deque(std::size_t capacity) :
+    top(0), bottom(0)
+{
+    std::int64_t size = 2;
+    while (size < std::int64_t(capacity)) {
+        size += size;
+    }
+    arrays.emplace_back(new array(size));
+    items.store(arrays.back().get(), std::memory_order_relaxed);
+}
+
+template<class Item>
+void work_stealing_deque<Item>::push(Item item) {
+    std::int64_t b = bottom.load(std::memory_order_relaxed);
+    std::int64_t t = top.load(std::memory_order_acquire);
+    array* a = items.load(std::memory_order_relaxed);
+
+    if (b - t > a->mask) {
+        a = grow(a, b, t);
+    }
+
+    a->put(b, item);
+    // publishes the item to thieves that acquire bottom
+    bottom.store(b + 1, std::memory_order_release);
+}
+
+template<class Item>
+bool work_stealing_deque<Item>::take(Item& item) {
+    std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    array* a = items.load(std::memory_order_relaxed);
+    // reserve the bottom item before looking at top
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t t = top.load(std::memory_order_relaxed);
+
+    bool result = true;
+    if (t <= b) {
+        item = a->get(b);
+        if (t == b) {
+            // last item, race against thieves
+            result = top.compare_exchange_strong(
+                t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed
+            );
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+    } else {
+        result = false;
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    return result;
+}
+
+template<class Item>
+bool work_stealing_deque<Item>::steal(Item& item) {
+    std::int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t b = bottom.load(std::memory_order_acquire);
+
+    if (t >= b) {
+        return false;
+    }
+
+    array* a = items.load(std::memory_order_acquire);
+    Item result = a->get(t);
+    if (!top.compare_exchange_strong(
+        t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed
+    )) {
+        return false;
+    }
+
+    item = result;
+    return true;
+}
+
+template<class Item>
+bool work_stealing_deque<Item>::empty() const {
+    std::int64_t b = bottom.load(std::memory_order_relaxed);
+    std::int64_t t = top.load(std::memory_order_relaxed);
+    return t >= b;
+}
+
+template<class Item>
+typename work_stealing_deque<Item>::array*
+work_stealing_deque<Item>::grow(array* a, std::int64_t b, std::int64_t t) {
+    array* bigger = new array(2 * (a->mask + 1));
+    for (std::int64_t i = t; i < b; i++) {
+        bigger->put(i, a->get(i));
+    }
+
+    arrays.emplace_back(bigger);
+    items.store(bigger, std::memory_order_release);
+    return bigger;
+}
+
+}
+
+#endif // WORK_STEALING_DEQUE_H
@@ -0,0 +1,13 @@
+#ifndef CACHE_LINE_H
+#define CACHE_LINE_H
+
+#include <cstddef>
+
+namespace fast {
+
+// std::hardware_destructive_interference_size needs C++17
+constexpr std::size_t cache_line_size = 64;
+
+}
+
+#endif // CACHE_LINE_H
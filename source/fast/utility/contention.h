@@ -0,0 +1,117 @@
+#ifndef CONTENTION_H
+#define CONTENTION_H
+
+#include <atomic>
+#include <cstddef>
+
+/* Define FAST_CONTENTION_COUNTERS as 1 to make the queues count
+ * contention events. It has to have the same value in every
+ * translation unit. When it is 0, the counters are empty and
+ * every update compiles to nothing. Queues derive from them, so
+ * the empty base takes no space either.
+ */
+#ifndef FAST_CONTENTION_COUNTERS
+#define FAST_CONTENTION_COUNTERS 0
+#endif
+
+namespace fast {
+
+struct contention_snapshot {
+    // compare exchanges and handshakes that had to be repeated
+    // because another thread got in first
+    std::size_t cas_retries;
+    // pops that couldn't swap lists because producers were writing
+    std::size_t swap_failures;
+    // pops and polls that found the queue empty
+    std::size_t empty_polls;
+    // storage allocated because the free storage was used up
+    std::size_t block_allocations;
+    // most elements seen in the queue at once
+    std::size_t peak_depth;
+};
+
+namespace detail {
+    template<bool Enabled>
+    struct basic_contention_counters {
+        void cas_retry() {}
+        void swap_failure() {}
+        void empty_poll() {}
+        void block_allocation() {}
+        // for queues that don't know their size
+        void pushed(std::size_t) {}
+        void popped(std::size_t) {}
+        // for queues that do
+        void depth(std::size_t) {}
+
+        contention_snapshot snapshot() const {
+            return {0, 0, 0, 0, 0};
+        }
+    };
+
+    template<>
+    struct basic_contention_counters<true> {
+        basic_contention_counters() :
+            cas_retries(0), swap_failures(0), empty_polls(0),
+            block_allocations(0), current_depth(0), peak_depth(0) {}
+
+        void cas_retry() {
+            cas_retries.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void swap_failure() {
+            swap_failures.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void empty_poll() {
+            empty_polls.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void block_allocation() {
+            block_allocations.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void pushed(std::size_t count) {
+            depth(
+                current_depth.fetch_add(count, std::memory_order_relaxed) +
+                count
+            );
+        }
+
+        void popped(std::size_t count) {
+            current_depth.fetch_sub(count, std::memory_order_relaxed);
+        }
+
+        void depth(std::size_t value) {
+            std::size_t peak = peak_depth.load(std::memory_order_relaxed);
+            while (value > peak && !peak_depth.compare_exchange_weak(
+                peak, value, std::memory_order_relaxed
+            )) {}
+        }
+
+        contention_snapshot snapshot() const {
+            return {
+                cas_retries.load(std::memory_order_relaxed),
+                swap_failures.load(std::memory_order_relaxed),
+                empty_polls.load(std::memory_order_relaxed),
+                block_allocations.load(std::memory_order_relaxed),
+                peak_depth.load(std::memory_order_relaxed)
+            };
+        }
+
+    private:
+        std::atomic<std::size_t> cas_retries;
+        std::atomic<std::size_t> swap_failures;
+        std::atomic<std::size_t> empty_polls;
+        std::atomic<std::size_t> block_allocations;
+        // queues count pushes before the elements become visible
+        std::atomic<std::size_t> current_depth;
+        std::atomic<std::size_t> peak_depth;
+    };
+}
+
+typedef detail::basic_contention_counters<FAST_CONTENTION_COUNTERS != 0>
+    contention_counters;
+
+}
+
+#endif // CONTENTION_H
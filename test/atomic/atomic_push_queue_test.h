@@ -1,4 +1,11 @@
 #include <doctest.h>
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <iterator>
+#include <thread>
+#include <type_traits>
 
 #include "source/fast/atomic/atomic_push_queue.h"
 
@@ -31,4 +38,195 @@ TEST_SUITE("atomic_push_queue") {
         result = queue.pop(number);
         CHECK(result == false);
     }
+
+    TEST_CASE("popped nodes should be reused by push") {
+        fast::atomic_push_queue<int> queue;
+
+        queue.push(1);
+        queue.push(2);
+
+        int number;
+        while (queue.pop(number)) {}
+
+        CHECK(queue.pool_size() == 2);
+
+        queue.push(3);
+        CHECK(queue.pool_size() == 1);
+
+        CHECK(queue.pop(number) == true);
+        CHECK(number == 3);
+    }
+
+    TEST_CASE("reserve should fill the pool") {
+        fast::atomic_push_queue<int> queue;
+
+        queue.reserve(10);
+        CHECK(queue.pool_size() == 10);
+
+        queue.reserve(5);
+        CHECK(queue.pool_size() == 10);
+
+        for (int i = 0; i < 10; i++) {
+            queue.push(int(i));
+        }
+        CHECK(queue.pool_size() == 0);
+
+        int number;
+        for (int i = 0; i < 10; i++) {
+            CHECK(queue.pop(number) == true);
+            CHECK(number == i);
+        }
+    }
+
+    TEST_CASE("push_range should push all elements in order") {
+        fast::atomic_push_queue<int> queue;
+        std::vector<int> numbers {1, 2, 3, 4};
+
+        queue.push(0);
+        queue.push_range(numbers.begin(), numbers.end());
+
+        int number;
+        for (int i = 0; i < 5; i++) {
+            CHECK(queue.pop(number) == true);
+            CHECK(number == i);
+        }
+        CHECK(queue.pop(number) == false);
+    }
+
+    TEST_CASE("a throwing push_range should return its nodes to the pool") {
+        struct throwing {
+            throwing(int value = 0) : value(value) {}
+            throwing(const throwing& o) : value(o.value) {
+                if (value < 0) {
+                    throw std::runtime_error("copy");
+                }
+            }
+            throwing& operator=(const throwing& o) {
+                if (o.value < 0) {
+                    throw std::runtime_error("copy");
+                }
+                value = o.value;
+                return *this;
+            }
+            int value;
+        };
+
+        fast::atomic_push_queue<throwing> queue;
+        queue.reserve(1);
+
+        // one pooled node, two new ones, then the copy throws
+        std::vector<throwing> items {1, 2, 3, 4};
+        items[3].value = -1;
+        CHECK_THROWS_AS(
+            queue.push_range(items.begin(), items.end()), std::runtime_error
+        );
+        CHECK(queue.pool_size() == 3);
+
+        // the pooled node is reused, then assigning throws
+        std::vector<throwing> first_bad {1};
+        first_bad[0].value = -1;
+        CHECK_THROWS_AS(
+            queue.push_range(first_bad.begin(), first_bad.end()),
+            std::runtime_error
+        );
+        CHECK(queue.pool_size() == 3);
+
+        throwing item;
+        CHECK(queue.pop(item) == false);
+    }
+
+    TEST_CASE("pop_all should move out all elements") {
+        fast::atomic_push_queue<std::unique_ptr<int>> queue;
+
+        for (int i = 0; i < 3; i++) {
+            queue.push(std::unique_ptr<int>(new int(i)));
+        }
+
+        std::vector<std::unique_ptr<int>> items;
+        queue.pop_all(std::back_inserter(items));
+
+        CHECK(items.size() == 3);
+        for (int i = 0; i < 3; i++) {
+            CHECK(*items[i] == i);
+        }
+
+        std::unique_ptr<int> item;
+        CHECK(queue.pop(item) == false);
+    }
+
+    TEST_CASE("consume_all should return the number of elements") {
+        fast::atomic_push_queue<int> queue;
+        std::vector<int> numbers {1, 2, 3};
+
+        queue.push_range(numbers.begin(), numbers.end());
+
+        int sum = 0;
+        CHECK(queue.consume_all([&sum](int&& i) { sum += i; }) == 3);
+        CHECK(sum == 6);
+        CHECK(queue.consume_all([](int&&) {}) == 0);
+    }
+
+    TEST_CASE("concurrent pushes should not be lost while popping") {
+        fast::atomic_push_queue<int> queue;
+        const int producers = 4;
+        const int count = 20000;
+
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; p++) {
+            threads.emplace_back([&queue, p]() {
+                for (int i = 0; i < count; i++) {
+                    queue.push(int(p * count + i));
+                }
+            });
+        }
+
+        std::vector<bool> seen(producers * count, false);
+        int received = 0;
+        int number;
+        while (received < producers * count / 2) {
+            if (queue.pop(number)) {
+                seen[number] = true;
+                received++;
+            }
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        while (queue.pop(number)) {
+            seen[number] = true;
+            received++;
+        }
+
+        CHECK(received == producers * count);
+        CHECK(std::find(seen.begin(), seen.end(), false) == seen.end());
+    }
+
+    TEST_CASE("contention counters should only count when enabled") {
+        fast::atomic_push_queue<int> queue;
+        int number;
+
+        CHECK(queue.pop(number) == false);
+        queue.push(1);
+        queue.push(2);
+        queue.push(3);
+        CHECK(queue.pop(number) == true);
+
+        fast::contention_snapshot counters = queue.contention();
+#if FAST_CONTENTION_COUNTERS
+        CHECK(counters.empty_polls == 1);
+        CHECK(counters.block_allocations == 3);
+        CHECK(counters.peak_depth == 3);
+        // nothing ran concurrently, walking the list is not contention
+        CHECK(counters.cas_retries == 0);
+#else
+        // an empty base, the queue doesn't grow
+        CHECK(std::is_empty<fast::contention_counters>::value);
+        CHECK(counters.empty_polls == 0);
+        CHECK(counters.block_allocations == 0);
+        CHECK(counters.peak_depth == 0);
+        CHECK(counters.cas_retries == 0);
+#endif
+        CHECK(counters.swap_failures == 0);
+    }
 }
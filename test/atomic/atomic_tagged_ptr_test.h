@@ -0,0 +1,61 @@
+#include <doctest.h>
+
+#include "source/fast/atomic/atomic_tagged_ptr.h"
+
+TEST_SUITE("atomic_tagged_ptr") {
+    TEST_CASE("tagged_ptr should keep pointer and tag apart") {
+        int value = 5;
+        fast::tagged_ptr<int> pointer(&value, 7);
+
+        CHECK(pointer.get() == &value);
+        CHECK(pointer.tag() == 7);
+        CHECK(*pointer == 5);
+    }
+
+    TEST_CASE("tags should wrap without touching the pointer") {
+        int value = 5;
+        std::uint64_t limit =
+            std::uint64_t(1) << (64 - fast::detail::tagged_pointer_bits);
+        fast::tagged_ptr<int> pointer(&value, limit + 3);
+
+        CHECK(pointer.get() == &value);
+        CHECK(pointer.tag() == 3);
+    }
+
+    TEST_CASE("every modification should increment the tag") {
+        int a, b;
+        fast::atomic_tagged_ptr<int> pointer(&a);
+
+        CHECK(pointer.load().tag() == 0);
+
+        pointer.store(&b);
+        CHECK(pointer.load().get() == &b);
+        CHECK(pointer.load().tag() == 1);
+
+        fast::tagged_ptr<int> old = pointer.exchange(&a);
+        CHECK(old.get() == &b);
+        CHECK(old.tag() == 1);
+        CHECK(pointer.load().tag() == 2);
+    }
+
+    TEST_CASE("compare_exchange should fail after a change back") {
+        int a, b;
+        fast::atomic_tagged_ptr<int> pointer(&a);
+
+        fast::tagged_ptr<int> expected = pointer.load();
+
+        pointer.store(&b);
+        pointer.store(&a);
+
+        CHECK(pointer.compare_exchange_strong(expected, &b) == false);
+        CHECK(expected.get() == &a);
+        CHECK(expected.tag() == 2);
+
+        CHECK(pointer.compare_exchange_strong(
+            expected, &b,
+            std::memory_order_acq_rel, std::memory_order_acquire
+        ) == true);
+        CHECK(pointer.load().get() == &b);
+        CHECK(pointer.load().tag() == 3);
+    }
+}
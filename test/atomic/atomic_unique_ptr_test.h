@@ -54,4 +54,56 @@ TEST_SUITE("atomic_unique_ptr") {
         pointer.store(t);
         CHECK(const_data->load() == t);
     }
+
+    TEST_CASE("retire should delete old value after critical sections") {
+        fast::epoch_domain domain;
+        fast::epoch_thread thread(domain);
+        fast::atomic_unique_ptr<test> pointer(new test());
+
+        {
+            fast::epoch_guard guard(thread);
+            test* t = pointer.load();
+
+            pointer.retire(new test(), thread);
+            thread.collect();
+            thread.collect();
+
+            CHECK(count == 2);
+            CHECK(t != pointer.load());
+        }
+
+        thread.collect();
+        thread.collect();
+        CHECK(count == 1);
+    }
+
+    TEST_CASE("exchange and release should give up ownership") {
+        fast::atomic_unique_ptr<test> pointer(new test());
+        test* t = new test();
+
+        test* old = pointer.exchange(t, std::memory_order_acq_rel);
+        CHECK(count == 2);
+        delete old;
+
+        CHECK(pointer.release() == t);
+        CHECK(pointer.load() == nullptr);
+        CHECK(count == 1);
+        delete t;
+    }
+
+    TEST_CASE("compare_exchange_strong should only replace expected") {
+        test* t = new test();
+        fast::atomic_unique_ptr<test> pointer(t);
+
+        test* expected = nullptr;
+        CHECK(pointer.compare_exchange_strong(expected, nullptr) == false);
+        CHECK(expected == t);
+
+        CHECK(pointer.compare_exchange_strong(
+            expected, nullptr,
+            std::memory_order_release, std::memory_order_relaxed
+        ) == true);
+        CHECK(pointer.load(std::memory_order_acquire) == nullptr);
+        delete t;
+    }
 }
@@ -0,0 +1,99 @@
+#include <doctest.h>
+
+#include <thread>
+
+#include "source/fast/atomic/epoch.h"
+
+TEST_SUITE("epoch") {
+    static int alive = 0;
+
+    struct counted {
+        counted() { alive++; }
+        ~counted() { alive--; }
+    };
+
+    TEST_CASE("retired object should survive the critical section") {
+        fast::epoch_domain domain;
+        {
+            fast::epoch_thread thread(domain);
+
+            {
+                fast::epoch_guard guard(thread);
+                thread.retire(new counted());
+
+                for (int i = 0; i < 4; i++) {
+                    thread.collect();
+                }
+                CHECK(alive == 1);
+            }
+
+            for (int i = 0; i < 4; i++) {
+                thread.collect();
+            }
+            CHECK(alive == 0);
+        }
+    }
+
+    TEST_CASE("critical section of another thread should block deletion") {
+        fast::epoch_domain domain;
+        fast::epoch_thread thread(domain);
+
+        {
+            fast::epoch_thread other(domain);
+            fast::epoch_guard guard(other);
+
+            thread.retire(new counted());
+            for (int i = 0; i < 4; i++) {
+                thread.collect();
+            }
+            CHECK(alive == 1);
+        }
+
+        for (int i = 0; i < 4; i++) {
+            thread.collect();
+        }
+        CHECK(alive == 0);
+    }
+
+    TEST_CASE("epoch should only advance past active threads") {
+        fast::epoch_domain domain;
+        fast::epoch_thread thread(domain);
+
+        thread.collect();
+        CHECK(domain.epoch() == 1);
+
+        fast::epoch_guard guard(thread);
+        thread.collect();
+        CHECK(domain.epoch() == 2);
+        thread.collect();
+        CHECK(domain.epoch() == 2);
+    }
+
+    TEST_CASE("destroying the domain should delete remaining objects") {
+        {
+            fast::epoch_domain domain;
+            fast::epoch_thread thread(domain);
+
+            thread.retire(new counted());
+            CHECK(alive == 1);
+        }
+        CHECK(alive == 0);
+    }
+
+    TEST_CASE("released registrations should be reused") {
+        fast::epoch_domain domain;
+
+        std::thread([&domain]() {
+            fast::epoch_thread thread(domain);
+            thread.retire(new counted());
+        }).join();
+        CHECK(alive == 1);
+
+        // takes over the record including its retired object
+        fast::epoch_thread thread(domain);
+        for (int i = 0; i < 4; i++) {
+            thread.collect();
+        }
+        CHECK(alive == 0);
+    }
+}
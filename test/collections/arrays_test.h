@@ -1,5 +1,10 @@
 #include <doctest.h>
 
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+
 #include "source/fast/collections/arrays.h"
 
 TEST_SUITE("arrays") {
@@ -46,4 +51,348 @@ TEST_SUITE("arrays") {
         a.erase(a.begin() + 5);
         CHECK(a.size() == 9);
     }
+
+    TEST_CASE("emplace_back should construct one element per column") {
+        fast::arrays<int, std::string> a;
+
+        for (int i = 0; i < 10; i++) {
+            a.emplace_back(i, std::to_string(i));
+        }
+
+        CHECK(a.size() == 10);
+        for (int i = 0; i < 10; i++) {
+            CHECK(a.get<0>().begin()[i] == i);
+            CHECK(a.get<std::string>().begin()[i] == std::to_string(i));
+        }
+    }
+
+    TEST_CASE("reserve should keep elements and pointers stable") {
+        fast::arrays<int, std::string> a;
+        a.emplace_back(1, "one");
+
+        a.reserve(100);
+        CHECK(a.capacity() == 100);
+        CHECK(a.size() == 1);
+        CHECK(a.get<std::string>().begin()[0] == "one");
+
+        int* first = a.get<int>().begin();
+        for (int i = 0; i < 99; i++) {
+            a.emplace_back(i, "");
+        }
+        CHECK(a.get<int>().begin() == first);
+
+        a.reserve(10);
+        CHECK(a.capacity() == 100);
+    }
+
+    TEST_CASE("emplace_back should read arguments before growing") {
+        fast::arrays<std::string, int> a;
+        std::string text(100, 'x');
+        for (int i = 0; i < 4; i++) {
+            a.emplace_back(text, i);
+        }
+        REQUIRE(a.size() == a.capacity());
+
+        // refers into the storage that growing replaces
+        a.emplace_back(a.get<0>().begin()[1], a.get<1>().begin()[3]);
+        CHECK(a.capacity() > 4);
+        CHECK(a.get<0>().begin()[4] == text);
+        CHECK(a.get<1>().begin()[4] == 3);
+        CHECK(a.get<0>().begin()[1] == text);
+    }
+
+    TEST_CASE("a throwing emplace_back should leave the table unchanged") {
+        struct throwing {
+            throwing(int value) : value(value) {
+                if (value < 0) {
+                    throw std::runtime_error("construct");
+                }
+            }
+            int value;
+        };
+
+        fast::arrays<throwing> a;
+        for (int i = 0; i < 4; i++) {
+            a.emplace_back(i);
+        }
+        REQUIRE(a.size() == a.capacity());
+
+        CHECK_THROWS_AS(a.emplace_back(-1), std::runtime_error);
+        CHECK(a.size() == 4);
+        CHECK(a.capacity() == 4);
+        CHECK(a.get<0>().begin()[3].value == 3);
+    }
+
+    TEST_CASE("shrink_to_fit should release unused capacity") {
+        fast::arrays<int, std::string> a;
+        a.reserve(64);
+        a.emplace_back(1, "one");
+        a.emplace_back(2, "two");
+
+        a.shrink_to_fit();
+        CHECK(a.capacity() == 2);
+        CHECK(a.get<std::string>().begin()[1] == "two");
+    }
+
+    TEST_CASE("columns should be aligned for their type") {
+        fast::arrays<char, double, short, long long> a;
+        a.emplace_back('a', 1.0, short(2), 3ll);
+
+        auto aligned = [](const void* p, size_t alignment) {
+            return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+        };
+        CHECK(aligned(a.get<double>().begin(), alignof(double)));
+        CHECK(aligned(a.get<short>().begin(), alignof(short)));
+        CHECK(aligned(a.get<long long>().begin(), alignof(long long)));
+    }
+
+    TEST_CASE("arrays should destroy every element exactly once") {
+        std::shared_ptr<int> counted(new int(0));
+        {
+            fast::arrays<std::shared_ptr<int>, int> a;
+            for (int i = 0; i < 20; i++) {
+                a.emplace_back(counted, i);
+            }
+            a.erase(a.begin());
+
+            fast::arrays<std::shared_ptr<int>, int> b(std::move(a));
+            CHECK(a.size() == 0);
+            CHECK(counted.use_count() == 20);
+
+            b.shrink_to_fit();
+            CHECK(counted.use_count() == 20);
+        }
+        CHECK(counted.use_count() == 1);
+    }
+
+    TEST_CASE("simd_arrays should align and pad every column") {
+        fast::simd_arrays<char, float, double> a;
+        for (int i = 0; i < 3; i++) {
+            a.emplace_back('a', 1.0f, 2.0);
+        }
+
+        // 64 rows of char are the first multiple of 64 bytes
+        CHECK(a.capacity() == 64);
+        auto aligned = [](const void* p) {
+            return reinterpret_cast<uintptr_t>(p) % fast::simd_alignment == 0;
+        };
+        CHECK(aligned(a.get<char>().begin()));
+        CHECK(aligned(a.get<float>().begin()));
+        CHECK(aligned(a.get<double>().begin()));
+
+        a.reserve(100);
+        CHECK(a.capacity() == 128);
+        CHECK(aligned(a.get<double>().begin()));
+        CHECK(a.get<double>().begin()[2] == 2.0);
+    }
+
+    TEST_CASE("sort_by should reorder every column by the key") {
+        fast::arrays<int, std::string, std::unique_ptr<int>> a;
+        std::mt19937 random(42);
+        for (int i = 0; i < 1000; i++) {
+            int key = int(random() % 2000) - 1000;
+            a.emplace_back(
+                key, std::to_string(key), std::unique_ptr<int>(new int(key))
+            );
+        }
+
+        a.sort_by<0>();
+
+        int previous = -1000;
+        for (auto row : a) {
+            int key = std::get<0>(row);
+            CHECK(previous <= key);
+            CHECK(std::get<1>(row) == std::to_string(key));
+            CHECK(*std::get<2>(row) == key);
+            previous = key;
+        }
+    }
+
+    TEST_CASE("sort_by should be stable") {
+        fast::arrays<std::uint64_t, int> a;
+        for (int i = 0; i < 100; i++) {
+            // one key above 2^32 so the high bytes are sorted too
+            a.emplace_back(i % 3 == 0 ? (1ull << 40) : std::uint64_t(i % 2), i);
+        }
+
+        a.sort_by<0>();
+
+        auto keys = a.get<0>().begin();
+        auto values = a.get<1>().begin();
+        for (int i = 1; i < 100; i++) {
+            CHECK(keys[i - 1] <= keys[i]);
+            if (keys[i - 1] == keys[i]) {
+                CHECK(values[i - 1] < values[i]);
+            }
+        }
+    }
+
+    TEST_CASE("sort_by should use the comparison") {
+        fast::arrays<std::string, int> a;
+        a.emplace_back("b", 1);
+        a.emplace_back("c", 2);
+        a.emplace_back("a", 0);
+
+        a.sort_by<0>(std::greater<std::string>());
+        CHECK(a.get<1>().begin()[0] == 2);
+        CHECK(a.get<1>().begin()[2] == 0);
+
+        a.sort_by<1>(std::greater<int>());
+        CHECK(a.get<0>().begin()[0] == "c");
+    }
+
+    TEST_CASE("apply_permutation should gather rows") {
+        fast::simd_arrays<float, int> a;
+        for (int i = 0; i < 5; i++) {
+            a.emplace_back(float(i), i);
+        }
+
+        std::uint32_t permutation[] = {4, 2, 0, 1, 3};
+        a.apply_permutation(
+            fast::span<const std::uint32_t>(permutation, permutation + 5)
+        );
+
+        for (int i = 0; i < 5; i++) {
+            CHECK(a.get<float>().begin()[i] == float(permutation[i]));
+            CHECK(a.get<int>().begin()[i] == int(permutation[i]));
+        }
+    }
+
+    TEST_CASE("view should iterate over the selected columns") {
+        fast::arrays<int, std::string, double, char> a;
+        for (int i = 0; i < 10; i++) {
+            a.emplace_back(i, std::to_string(i), i * 0.5, 'a');
+        }
+
+        auto v = a.view<2, 0>();
+        CHECK(v.size() == 10);
+
+        int next = 0;
+        for (auto row : v) {
+            CHECK(std::get<0>(row) == next * 0.5);
+            CHECK(std::get<1>(row) == next);
+            // references into the table
+            std::get<1>(row) *= 10;
+            next++;
+        }
+        CHECK(next == 10);
+        CHECK(a.get<0>().begin()[9] == 90);
+        CHECK(v.get<1>().begin()[9] == 90);
+    }
+
+    TEST_CASE("view should select columns by type") {
+        fast::arrays<int, std::string, double> a;
+        a.emplace_back(1, "one", 1.0);
+        a.emplace_back(2, "two", 2.0);
+
+        auto v = a.view<std::string, int>();
+        auto i = v.begin();
+        CHECK(std::get<0>(*i) == "one");
+        i++;
+        CHECK(std::get<1>(*i) == 2);
+        CHECK(++i == v.end());
+    }
+
+    TEST_CASE("iterator should support random access") {
+        fast::arrays<int, double> a;
+        for (int i = 0; i < 10; i++) {
+            a.emplace_back(i, i * 2.0);
+        }
+
+        auto first = a.begin();
+        auto last = a.end();
+        CHECK(last - first == 10);
+        CHECK(first + 10 == last);
+        CHECK(10 + first == last);
+        CHECK(last - 10 == first);
+        CHECK(first < last);
+        CHECK(last > first);
+        CHECK(first <= first);
+        CHECK(last >= first);
+        CHECK(std::get<0>(first[7]) == 7);
+
+        auto i = first;
+        i += 4;
+        CHECK(std::get<1>(*i) == 8.0);
+        i -= 2;
+        CHECK(std::get<0>(*i--) == 2);
+        CHECK(std::get<0>(*i) == 1);
+        CHECK(std::distance(first, last) == 10);
+    }
+
+    TEST_CASE("rows should be sortable with std::sort") {
+        fast::arrays<int, std::string, std::unique_ptr<int>> a;
+        std::mt19937 random(7);
+        for (int i = 0; i < 1000; i++) {
+            int key = int(random() % 100);
+            a.emplace_back(
+                key, std::to_string(key), std::unique_ptr<int>(new int(key))
+            );
+        }
+
+        std::sort(a.begin(), a.end(), [](const auto& l, const auto& r) {
+            return std::get<0>(l) < std::get<0>(r);
+        });
+
+        auto keys = a.get<0>().begin();
+        for (size_t i = 0; i < a.size(); i++) {
+            if (i > 0) {
+                CHECK(keys[i - 1] <= keys[i]);
+            }
+            CHECK(a.get<1>().begin()[i] == std::to_string(keys[i]));
+            CHECK(*a.get<2>().begin()[i] == keys[i]);
+        }
+    }
+
+    TEST_CASE("rows should compare like tuples") {
+        fast::arrays<int, std::string> a;
+        a.emplace_back(2, "b");
+        a.emplace_back(1, "z");
+        a.emplace_back(2, "a");
+        a.emplace_back(0, "x");
+
+        std::sort(a.begin(), a.end());
+        CHECK(std::get<0>(*a.begin()) == 0);
+        CHECK(std::get<1>(a.begin()[2]) == "a");
+        CHECK(std::get<1>(a.begin()[3]) == "b");
+
+        auto found = std::lower_bound(
+            a.begin(), a.end(), std::make_tuple(2, std::string("b"))
+        );
+        CHECK(found - a.begin() == 3);
+    }
+
+    TEST_CASE("nth_element should partition rows") {
+        fast::arrays<int, int> a;
+        for (int i = 0; i < 101; i++) {
+            a.emplace_back((i * 37) % 101, i);
+        }
+
+        auto middle = a.begin() + 50;
+        std::nth_element(a.begin(), middle, a.end());
+        CHECK(std::get<0>(*middle) == 50);
+        for (auto i = a.begin(); i != middle; ++i) {
+            CHECK(std::get<0>(*i) < 50);
+            CHECK((std::get<0>(*i) * 71) % 101 == std::get<1>(*i));
+        }
+    }
+
+    TEST_CASE("swap should exchange rows") {
+        fast::arrays<int, std::string> a;
+        a.emplace_back(1, "one");
+        a.emplace_back(2, "two");
+
+        using std::swap;
+        swap(*a.begin(), a.begin()[1]);
+        CHECK(std::get<1>(*a.begin()) == "two");
+        CHECK(a.get<0>().begin()[1] == 1);
+
+        // a copy of a row outlives changes to the table
+        std::tuple<int, std::string> row = *a.begin();
+        CHECK(a.get<1>().begin()[0] == "two");
+        *a.begin() = a.begin()[1];
+        CHECK(std::get<1>(row) == "two");
+        CHECK(a.get<1>().begin()[0] == "one");
+        CHECK(a.get<1>().begin()[1] == "one");
+    }
 }
@@ -0,0 +1,136 @@
+#include <doctest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "source/fast/collections/arrays_tiled.h"
+
+TEST_SUITE("arrays_tiled") {
+    TEST_CASE("insert should store elements across tiles") {
+        fast::arrays_tiled<16, int, double> a;
+
+        for (int i = 0; i < 40; i++) {
+            a.insert(std::make_tuple(i, i * 0.5));
+        }
+
+        CHECK(a.size() == 40);
+        CHECK(a.tiles() == 3);
+
+        int next = 0;
+        for (auto i : a) {
+            CHECK(std::get<0>(i) == next);
+            CHECK(std::get<1>(i) == next * 0.5);
+            next++;
+        }
+        CHECK(next == 40);
+    }
+
+    TEST_CASE("get should return the column run of a tile") {
+        fast::arrays_tiled<16, float, std::int32_t> a;
+        for (int i = 0; i < 20; i++) {
+            a.emplace_back(float(i), i);
+        }
+
+        fast::span<float> first = a.get<float>(0);
+        fast::span<std::int32_t> last = a.get<1>(1);
+        CHECK(first.end() - first.begin() == 16);
+        CHECK(last.end() - last.begin() == 4);
+        CHECK(first.begin()[15] == 15.0f);
+        CHECK(last.begin()[3] == 19);
+
+        auto aligned = [](const void* p) {
+            return reinterpret_cast<uintptr_t>(p) % fast::simd_alignment == 0;
+        };
+        CHECK(aligned(first.begin()));
+        CHECK(aligned(last.begin()));
+    }
+
+    TEST_CASE("erase should move the last row") {
+        fast::arrays_tiled<4, int, std::string> a;
+        for (int i = 0; i < 10; i++) {
+            a.emplace_back(i, std::to_string(i));
+        }
+
+        a.erase(a.begin() + 2);
+        CHECK(a.size() == 9);
+        CHECK(a.tiles() == 3);
+        CHECK(a.get<int>(0).begin()[2] == 9);
+        CHECK(a.get<std::string>(0).begin()[2] == "9");
+    }
+
+    TEST_CASE("arrays_tiled should destroy every element once") {
+        std::shared_ptr<int> counted(new int(0));
+        {
+            fast::arrays_tiled<8, std::shared_ptr<int>, char> a;
+            a.reserve(3);
+            CHECK(a.capacity() == 8);
+
+            for (int i = 0; i < 30; i++) {
+                a.emplace_back(counted, 'a');
+            }
+            a.erase(a.begin() + 7);
+            CHECK(counted.use_count() == 30);
+
+            fast::arrays_tiled<8, std::shared_ptr<int>, char> b(std::move(a));
+            CHECK(a.size() == 0);
+            CHECK(counted.use_count() == 30);
+        }
+        CHECK(counted.use_count() == 1);
+    }
+
+    TEST_CASE("copying a row should leave the table unchanged") {
+        fast::arrays_tiled<4, int, std::string> a;
+        std::string text(50, 'x');
+        for (int i = 0; i < 6; i++) {
+            a.emplace_back(i, text);
+        }
+
+        std::vector<std::tuple<int, std::string>> copy;
+        for (auto i = a.begin(); i != a.end(); ++i) {
+            copy.push_back(*i);
+        }
+
+        CHECK(std::get<1>(copy[5]) == text);
+        CHECK(a.get<std::string>(1).begin()[1] == text);
+    }
+
+    TEST_CASE("rows should be sortable across tiles") {
+        fast::arrays_tiled<4, int, std::string> a;
+        for (int i = 0; i < 30; i++) {
+            int key = (i * 7) % 30;
+            a.emplace_back(key, std::to_string(key));
+        }
+
+        std::sort(a.begin(), a.end(), [](const auto& l, const auto& r) {
+            return std::get<0>(l) < std::get<0>(r);
+        });
+
+        int next = 0;
+        for (auto i = a.begin(); i != a.end(); i++) {
+            CHECK(std::get<0>(*i) == next);
+            CHECK(std::get<1>(*i) == std::to_string(next));
+            next++;
+        }
+        CHECK(a.end() - a.begin() == 30);
+        CHECK(std::get<0>(a.begin()[17]) == 17);
+        CHECK(a.begin() + 30 == a.end());
+        CHECK(a.begin() < a.end());
+    }
+
+    TEST_CASE("emplace_back should read arguments before growing") {
+        fast::arrays_tiled<4, std::string, int> a;
+        std::string text(100, 'x');
+        for (int i = 0; i < 4; i++) {
+            a.emplace_back(text, i);
+        }
+        REQUIRE(a.size() == a.capacity());
+
+        a.emplace_back(a.get<0>(0).begin()[1], a.get<1>(0).begin()[3]);
+        CHECK(a.get<0>(1).begin()[0] == text);
+        CHECK(a.get<1>(1).begin()[0] == 3);
+    }
+}
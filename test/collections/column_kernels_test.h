@@ -0,0 +1,138 @@
+#include <doctest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "source/fast/collections/arrays.h"
+#include "source/fast/collections/column_kernels.h"
+
+namespace column_kernels_test {
+    // odd sizes so the vector paths leave a scalar tail
+    template<class Type>
+    fast::simd_arrays<Type> make_column(int size) {
+        fast::simd_arrays<Type> a;
+        for (int i = 0; i < size; i++) {
+            a.emplace_back(Type(i % 10));
+        }
+        return a;
+    }
+
+    template<class Type>
+    void check_sum() {
+        auto a = make_column<Type>(103);
+        // ten times 0 + ... + 9, then 0, 1, 2
+        CHECK(fast::sum(a.template get<Type>()) == Type(10 * 45 + 3));
+    }
+
+    template<class Type>
+    void check_multiply_add() {
+        auto a = make_column<Type>(37);
+        fast::span<Type> column = a.template get<Type>();
+
+        fast::multiply_add(column, Type(3), Type(1), column);
+        for (int i = 0; i < 37; i++) {
+            CHECK(column.begin()[i] == Type(i % 10 * 3 + 1));
+        }
+    }
+
+    template<class Type>
+    void check_select_greater() {
+        auto a = make_column<Type>(45);
+        std::vector<std::uint32_t> indices(45);
+
+        std::size_t count = fast::select_greater(
+            a.template get<Type>(), Type(6), indices.data()
+        );
+
+        // 7, 8 and 9 in every ten, and none of the tail 0...4
+        REQUIRE(count == 12);
+        for (std::size_t i = 0; i < count; i++) {
+            CHECK(indices[i] % 10 > 6);
+            if (i > 0) {
+                CHECK(indices[i - 1] < indices[i]);
+            }
+        }
+    }
+
+    template<class Type>
+    void check_gather_scatter() {
+        auto a = make_column<Type>(21);
+        std::vector<std::uint32_t> order;
+        for (std::uint32_t i = 0; i < 21; i++) {
+            order.push_back(20 - i);
+        }
+        fast::span<std::uint32_t> indices(order.data(), order.data() + 21);
+
+        std::vector<Type> reversed(21);
+        fast::span<Type> out(reversed.data(), reversed.data() + 21);
+        fast::gather(a.template get<Type>(), indices, out);
+        for (int i = 0; i < 21; i++) {
+            CHECK(reversed[i] == Type((20 - i) % 10));
+        }
+
+        std::vector<Type> restored(21);
+        fast::scatter(
+            out, indices,
+            fast::span<Type>(restored.data(), restored.data() + 21)
+        );
+        for (int i = 0; i < 21; i++) {
+            CHECK(restored[i] == Type(i % 10));
+        }
+    }
+}
+
+TEST_SUITE("column_kernels") {
+    using namespace column_kernels_test;
+
+    TEST_CASE("sum should add every element") {
+        check_sum<float>();
+        check_sum<double>();
+        check_sum<std::int32_t>();
+        check_sum<std::int64_t>();
+    }
+
+    TEST_CASE("multiply_add should scale every element") {
+        check_multiply_add<float>();
+        check_multiply_add<double>();
+        check_multiply_add<std::int32_t>();
+        check_multiply_add<std::int64_t>();
+    }
+
+    TEST_CASE("select_greater should list matching rows in order") {
+        check_select_greater<float>();
+        check_select_greater<double>();
+        check_select_greater<std::int32_t>();
+        check_select_greater<std::int16_t>();
+    }
+
+    TEST_CASE("gather and scatter should be inverse") {
+        check_gather_scatter<float>();
+        check_gather_scatter<double>();
+        check_gather_scatter<std::int32_t>();
+        check_gather_scatter<std::int64_t>();
+    }
+
+    TEST_CASE("transform, reduce and select should call the function") {
+        auto a = make_column<int>(10);
+        std::vector<long> squares(10);
+
+        fast::transform(
+            a.get<int>(), fast::span<long>(squares.data(), squares.data() + 10),
+            [](int x) { return long(x) * x; }
+        );
+        CHECK(squares[9] == 81);
+
+        long total = fast::reduce(
+            fast::span<long>(squares.data(), squares.data() + 10), 0l,
+            [](long sum, long x) { return sum + x; }
+        );
+        CHECK(total == 285);
+
+        std::uint32_t indices[10];
+        std::size_t count = fast::select(
+            a.get<int>(), [](int x) { return x % 2 == 0; }, indices
+        );
+        CHECK(count == 5);
+        CHECK(indices[4] == 8);
+    }
+}
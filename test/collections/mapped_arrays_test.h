@@ -0,0 +1,145 @@
+#include <doctest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "source/fast/collections/mapped_arrays.h"
+
+namespace mapped_arrays_test {
+    const char* path = "mapped_arrays_test.bin";
+
+    fast::arrays<std::int32_t, double, char> make_table(int rows) {
+        fast::arrays<std::int32_t, double, char> a;
+        for (int i = 0; i < rows; i++) {
+            a.emplace_back(i, i * 0.5, char('a' + i % 26));
+        }
+        return a;
+    }
+
+    std::vector<char> read_file(const char* path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<char>(
+            std::istreambuf_iterator<char>(file),
+            std::istreambuf_iterator<char>()
+        );
+    }
+
+    void write_file(const char* path, const std::vector<char>& bytes) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), std::streamsize(bytes.size()));
+    }
+}
+
+TEST_SUITE("mapped_arrays") {
+    using namespace mapped_arrays_test;
+
+    TEST_CASE("open should map the columns written by save") {
+        REQUIRE(fast::save(make_table(1000), path));
+
+        fast::mapped_arrays<std::int32_t, double, char> m;
+        REQUIRE(m.open(path));
+        CHECK(m.size() == 1000);
+
+        const fast::mapped_arrays<std::int32_t, double, char>& c = m;
+        for (int i = 0; i < 1000; i++) {
+            CHECK(c.get<std::int32_t>().begin()[i] == i);
+            CHECK(c.get<1>().begin()[i] == i * 0.5);
+            CHECK(c.get<char>().begin()[i] == char('a' + i % 26));
+        }
+
+        auto aligned = [](const void* p) {
+            return reinterpret_cast<uintptr_t>(p) % fast::simd_alignment == 0;
+        };
+        CHECK(aligned(c.get<double>().begin()));
+        CHECK(aligned(c.get<char>().begin()));
+
+        m.close();
+        std::remove(path);
+    }
+
+    TEST_CASE("open should reject files of other columns") {
+        REQUIRE(fast::save(make_table(10), path));
+
+        fast::mapped_arrays<std::int32_t, float, char> wrong_type;
+        CHECK(!wrong_type.open(path));
+        CHECK(!wrong_type.is_open());
+
+        fast::mapped_arrays<std::int32_t, double> wrong_count;
+        CHECK(!wrong_count.open(path));
+
+        fast::mapped_arrays<std::int32_t, double, char> missing;
+        std::remove(path);
+        CHECK(!missing.open(path));
+    }
+
+    TEST_CASE("open should reject truncated files") {
+        REQUIRE(fast::save(make_table(100), path));
+        std::vector<char> bytes = read_file(path);
+        bytes.resize(bytes.size() / 2);
+        write_file(path, bytes);
+
+        fast::mapped_arrays<std::int32_t, double, char> m;
+        CHECK(!m.open(path));
+        std::remove(path);
+    }
+
+    TEST_CASE("open should reject row counts that overflow") {
+        fast::arrays<double> a;
+        a.emplace_back(1.0);
+        REQUIRE(fast::save(a, path));
+
+        // rows * sizeof(double) wraps around to the 0 bytes of the column
+        std::vector<char> bytes = read_file(path);
+        std::uint64_t rows = std::uint64_t(1) << 61;
+        std::uint64_t column_bytes = 0;
+        std::memcpy(&bytes[16], &rows, sizeof(rows));
+        std::memcpy(&bytes[40], &column_bytes, sizeof(column_bytes));
+        write_file(path, bytes);
+
+        fast::mapped_arrays<double> m;
+        CHECK(!m.open(path));
+        CHECK(m.size() == 0);
+        std::remove(path);
+    }
+
+    TEST_CASE("copy_on_write should leave the file unchanged") {
+        REQUIRE(fast::save(make_table(100), path));
+
+        {
+            fast::mapped_arrays<std::int32_t, double, char> m;
+            REQUIRE(m.open(path, true));
+            m.get_mutable<0>().begin()[5] = -1;
+            CHECK(m.get<0>().begin()[5] == -1);
+        }
+
+        fast::mapped_arrays<std::int32_t, double, char> m;
+        REQUIRE(m.open(path));
+        // a non-const read only mapping reads through the const get
+        CHECK(m.get<0>().begin()[5] == 5);
+        CHECK(m.get<std::int32_t>().end() - m.get<0>().begin() == 100);
+
+        auto table = m.promote<fast::simd_alignment>();
+        CHECK(table.size() == 100);
+        table.emplace_back(100, 50.0, 'w');
+        CHECK(table.get<1>().begin()[99] == 49.5);
+        CHECK(table.get<2>().begin()[100] == 'w');
+
+        m.close();
+        std::remove(path);
+    }
+
+    TEST_CASE("empty tables should round trip") {
+        REQUIRE(fast::save(make_table(0), path));
+
+        fast::mapped_arrays<std::int32_t, double, char> m;
+        REQUIRE(m.open(path));
+        CHECK(m.size() == 0);
+
+        m.close();
+        std::remove(path);
+    }
+}
@@ -0,0 +1,74 @@
+#include <doctest.h>
+
+#include <atomic>
+
+#include "source/fast/collections/parallel_arrays.h"
+
+TEST_SUITE("parallel_arrays") {
+    TEST_CASE("parallel_for_each should visit every row once") {
+        fast::thread_pool pool(3);
+        fast::arrays<int, double, int> a;
+        for (int i = 0; i < 10000; i++) {
+            a.emplace_back(i, 0.5, 0);
+        }
+
+        fast::parallel_for_each(
+            pool, a, [](int& i, double& d, int& visits) {
+                d += i;
+                visits++;
+            }
+        );
+
+        for (auto row : a) {
+            CHECK(std::get<1>(row) == std::get<0>(row) + 0.5);
+            CHECK(std::get<2>(row) == 1);
+        }
+    }
+
+    TEST_CASE("parallel_transform should write the output column") {
+        fast::thread_pool pool(2);
+        fast::simd_arrays<float, float, float> a;
+        for (int i = 0; i < 5000; i++) {
+            a.emplace_back(float(i), 2.0f, 0.0f);
+        }
+
+        fast::parallel_transform<2, 0, 1>(pool, a, [](float x, float y) {
+            return x * y;
+        });
+
+        for (int i = 0; i < 5000; i++) {
+            CHECK(a.get<2>().begin()[i] == float(2 * i));
+        }
+    }
+
+    TEST_CASE("parallel_columns should call the function for every column") {
+        fast::thread_pool pool(2);
+        fast::arrays<int, long, short> a;
+        for (int i = 0; i < 100; i++) {
+            a.emplace_back(i, long(i), short(i));
+        }
+
+        std::atomic_int columns(0);
+        fast::parallel_columns(pool, a, [&columns](auto column) {
+            for (auto& x : column) {
+                x *= 2;
+            }
+            columns++;
+        });
+
+        CHECK(columns == 3);
+        CHECK(a.get<0>().begin()[99] == 198);
+        CHECK(a.get<1>().begin()[99] == 198);
+        CHECK(a.get<2>().begin()[99] == 198);
+    }
+
+    TEST_CASE("parallel passes should accept empty arrays") {
+        fast::thread_pool pool(2);
+        fast::arrays<int> a;
+
+        int calls = 0;
+        fast::parallel_for_each(pool, a, [&calls](int&) { calls++; });
+        fast::parallel_transform<0, 0>(pool, a, [](int x) { return x; });
+        CHECK(calls == 0);
+    }
+}
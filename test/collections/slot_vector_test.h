@@ -0,0 +1,138 @@
+#include <doctest.h>
+
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "source/fast/collections/slot_vector.h"
+
+TEST_SUITE("slot_vector") {
+    TEST_CASE("handles should be small and trivially copyable") {
+        typedef fast::slot_vector<std::string>::handle handle;
+        CHECK(sizeof(handle) == 8);
+        CHECK(std::is_trivially_copyable<handle>::value);
+    }
+
+    TEST_CASE("insert should store element") {
+        fast::slot_vector<std::string> v;
+        CHECK(v.size() == 0);
+
+        auto h = v.insert("five");
+        CHECK(v.size() == 1);
+        CHECK(v[h] == "five");
+        CHECK(*v.get(h) == "five");
+        CHECK(*v.begin() == "five");
+    }
+
+    TEST_CASE("erase should keep other handles valid") {
+        fast::slot_vector<int> v;
+        std::vector<fast::slot_vector<int>::handle> handles;
+        for (int i = 0; i < 100; i++) {
+            handles.push_back(v.insert(i));
+        }
+
+        for (int i = 0; i < 100; i += 3) {
+            CHECK(v.erase(handles[i]));
+        }
+        CHECK(v.size() == 66);
+
+        for (int i = 0; i < 100; i++) {
+            if (i % 3 == 0) {
+                CHECK(!v.contains(handles[i]));
+                CHECK(v.get(handles[i]) == nullptr);
+            } else {
+                CHECK(v[handles[i]] == i);
+            }
+        }
+
+        int sum = 0;
+        for (int i : v) {
+            sum += i;
+        }
+        CHECK(sum == 4950 - 1683);
+    }
+
+    TEST_CASE("stale handles should not see reused slots") {
+        fast::slot_vector<std::unique_ptr<int>> v;
+        auto old = v.insert(std::unique_ptr<int>(new int(1)));
+        CHECK(v.erase(old));
+        CHECK(!v.erase(old));
+
+        auto h = v.insert(std::unique_ptr<int>(new int(2)));
+        CHECK(h.index == old.index);
+        CHECK(h != old);
+        CHECK(v.get(old) == nullptr);
+        CHECK(*v[h] == 2);
+        CHECK(!v.contains(fast::slot_vector<std::unique_ptr<int>>::handle()));
+    }
+
+    TEST_CASE("handles to free slots should be rejected") {
+        fast::slot_vector<int> v;
+        auto h = v.insert(1);
+        v.insert(2);
+        CHECK(v.erase(h));
+
+        // e.g. a handle read back from another run
+        fast::slot_vector<int>::handle forged{h.index, h.generation + 1};
+        CHECK(!v.contains(forged));
+        CHECK(v.get(forged) == nullptr);
+        CHECK(!v.erase(forged));
+        CHECK(v.size() == 1);
+    }
+
+    TEST_CASE("handles should survive a byte copy") {
+        fast::slot_vector<int> v;
+        v.insert(1);
+        auto h = v.insert(2);
+
+        unsigned char bytes[sizeof(h)];
+        std::memcpy(bytes, &h, sizeof(h));
+        fast::slot_vector<int>::handle copy;
+        std::memcpy(&copy, bytes, sizeof(copy));
+
+        CHECK(copy == h);
+        CHECK(v[copy] == 2);
+    }
+
+    TEST_CASE("insert should copy elements of the same slot_vector") {
+        fast::slot_vector<std::string> v;
+        auto h = v.insert(std::string(100, 'x'));
+        for (int i = 0; i < 3; i++) {
+            v.insert(std::to_string(i));
+        }
+
+        // the copy is taken before the storage grows
+        auto copy = v.insert(v[h]);
+        CHECK(v[copy] == std::string(100, 'x'));
+        CHECK(v[h] == std::string(100, 'x'));
+    }
+
+    TEST_CASE("a throwing insert should leave no live slot") {
+        struct throwing {
+            throwing(int value) : value(value) {}
+            throwing(const throwing& o) : value(o.value) {
+                if (value < 0) {
+                    throw std::runtime_error("copy");
+                }
+            }
+            throwing(throwing&&) = default;
+            throwing& operator=(throwing&&) = default;
+            int value;
+        };
+
+        fast::slot_vector<throwing> v;
+        auto first = v.insert(throwing(1));
+        const throwing bad(-1);
+        CHECK_THROWS_AS(v.insert(bad), std::runtime_error);
+        CHECK(v.size() == 1);
+
+        // the slot is reused instead of being lost
+        auto second = v.insert(throwing(2));
+        CHECK(second.index == first.index + 1);
+        CHECK(v[second].value == 2);
+        CHECK(!v.contains({second.index, second.generation + 2}));
+    }
+}
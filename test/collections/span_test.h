@@ -1,4 +1,5 @@
 #include <doctest.h>
+#include <type_traits>
 #include <vector>
 
 #include "source/fast/collections/span.h"
@@ -28,4 +29,25 @@ TEST_SUITE("span") {
         }
         CHECK(alive == 0);
     }
+
+    TEST_CASE("span converts only to span of const") {
+        struct base { int a; };
+        struct derived : base { int b; };
+
+        CHECK(std::is_convertible<
+            fast::span<int>, fast::span<const int>
+        >::value);
+        CHECK(!std::is_convertible<
+            fast::span<const int>, fast::span<int>
+        >::value);
+        // indexing a span<base> over derived would use the wrong stride
+        CHECK(!std::is_convertible<
+            fast::span<derived>, fast::span<base>
+        >::value);
+
+        std::vector<int> numbers {1, 2};
+        fast::span<int> s(&*numbers.begin(), &*numbers.end());
+        fast::span<const int> c = s;
+        CHECK(c.begin()[1] == 2);
+    }
 }
@@ -0,0 +1,68 @@
+#include <doctest.h>
+
+#include <thread>
+#include <vector>
+
+#include "source/fast/coroutine/async_queue.h"
+
+namespace {
+    fast::task sum_values(
+        fast::scheduler& s, fast::async_queue<int>& queue,
+        long& sum, int count
+    ) {
+        for (int i = 0; i < count; i++) {
+            sum += co_await queue.pop();
+        }
+        s.stop();
+    }
+
+    fast::task pop_and_log(
+        fast::async_queue<int>& queue, std::vector<int>& log
+    ) {
+        log.push_back(co_await queue.pop());
+        log.push_back(co_await queue.pop());
+    }
+}
+
+TEST_SUITE("async_queue") {
+    TEST_CASE("pop should suspend until the next push") {
+        fast::scheduler s;
+        fast::async_queue<int> queue(s);
+        std::vector<int> log;
+
+        queue.push(1);
+        s.spawn(pop_and_log(queue, log));
+        s.run_ready();
+        CHECK(log == std::vector<int>{1});
+
+        CHECK(s.run_ready() == 0);
+        queue.emplace(2);
+        CHECK(s.run_ready() == 1);
+        CHECK(log == std::vector<int>{1, 2});
+
+        int number = 0;
+        CHECK(queue.try_pop(number) == false);
+        queue.push(3);
+        CHECK(queue.try_pop(number) == true);
+        CHECK(number == 3);
+    }
+
+    TEST_CASE("consumer coroutine should receive every pushed element") {
+        const int count = 100000;
+        fast::scheduler s;
+        fast::async_queue<int> queue(s);
+        long sum = 0;
+
+        s.spawn(sum_values(s, queue, sum, count));
+        std::thread runner([&s]() {
+            s.run();
+        });
+
+        for (int i = 0; i < count; i++) {
+            queue.push(i);
+        }
+
+        runner.join();
+        CHECK(sum == long(count) * (count - 1) / 2);
+    }
+}
@@ -0,0 +1,91 @@
+#include <doctest.h>
+
+#include <thread>
+#include <vector>
+
+#include "source/fast/coroutine/async_semaphore.h"
+
+namespace {
+    fast::task acquire_and_log(
+        fast::async_semaphore& semaphore, std::vector<int>& log, int id
+    ) {
+        co_await semaphore.acquire();
+        log.push_back(id);
+    }
+
+    fast::task acquire_and_count(
+        fast::scheduler& s, fast::async_semaphore& semaphore,
+        int& count, int total
+    ) {
+        co_await semaphore.acquire();
+        if (++count == total) {
+            s.stop();
+        }
+    }
+}
+
+TEST_SUITE("async_semaphore") {
+    TEST_CASE("acquire should not suspend while the count is positive") {
+        fast::scheduler s;
+        fast::async_semaphore semaphore(s, 1);
+        std::vector<int> log;
+
+        s.spawn(acquire_and_log(semaphore, log, 1));
+        s.run_ready();
+        CHECK(log == std::vector<int>{1});
+        CHECK(semaphore.try_acquire() == false);
+    }
+
+    TEST_CASE("release should resume waiters in arrival order") {
+        fast::scheduler s;
+        fast::async_semaphore semaphore(s);
+        std::vector<int> log;
+
+        for (int i = 0; i < 3; i++) {
+            s.spawn(acquire_and_log(semaphore, log, i));
+        }
+        s.run_ready();
+        CHECK(log.empty());
+
+        semaphore.release(2);
+        s.run_ready();
+        CHECK(log == std::vector<int>{0, 1});
+
+        semaphore.release();
+        semaphore.release();
+        s.run_ready();
+        CHECK(log == std::vector<int>{0, 1, 2});
+        CHECK(semaphore.try_acquire() == true);
+        CHECK(semaphore.try_acquire() == false);
+    }
+
+    TEST_CASE("thousands of waiters should need a single thread") {
+        const int waiters = 5000;
+        fast::scheduler s;
+        fast::async_semaphore semaphore(s);
+        int count = 0;
+
+        for (int i = 0; i < waiters; i++) {
+            s.spawn(acquire_and_count(s, semaphore, count, waiters));
+        }
+
+        std::thread runner([&s]() {
+            s.run();
+        });
+
+        std::vector<std::thread> releasers;
+        for (int r = 0; r < 4; r++) {
+            releasers.emplace_back([&semaphore]() {
+                for (int i = 0; i < waiters / 4; i++) {
+                    semaphore.release();
+                }
+            });
+        }
+
+        for (auto& t : releasers) {
+            t.join();
+        }
+        runner.join();
+        CHECK(count == waiters);
+    }
+}
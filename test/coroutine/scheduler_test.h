@@ -0,0 +1,62 @@
+#include <doctest.h>
+
+#include <thread>
+#include <vector>
+
+#include "source/fast/coroutine/scheduler.h"
+
+namespace {
+    fast::task record(fast::scheduler& s, std::vector<int>& log, int id) {
+        log.push_back(id);
+        co_await s.schedule();
+        log.push_back(id + 10);
+    }
+
+    fast::task hop(fast::scheduler& s, std::thread::id& resumed_on) {
+        co_await s.schedule();
+        resumed_on = std::this_thread::get_id();
+        s.stop();
+    }
+}
+
+TEST_SUITE("scheduler") {
+    TEST_CASE("run_ready should resume coroutines in posting order") {
+        fast::scheduler s;
+        std::vector<int> log;
+
+        s.spawn(record(s, log, 1));
+        s.spawn(record(s, log, 2));
+        CHECK(log.empty());
+
+        CHECK(s.run_ready() == 2);
+        CHECK(log == std::vector<int>{1, 2});
+
+        CHECK(s.run_ready() == 2);
+        CHECK(log == std::vector<int>{1, 2, 11, 12});
+        CHECK(s.run_ready() == 0);
+    }
+
+    TEST_CASE("a task that is never spawned should be destroyed") {
+        fast::scheduler s;
+        std::vector<int> log;
+        {
+            fast::task t = record(s, log, 1);
+        }
+        CHECK(s.run_ready() == 0);
+        CHECK(log.empty());
+    }
+
+    TEST_CASE("schedule should continue on the running thread") {
+        fast::scheduler s;
+        std::thread::id resumed_on;
+
+        std::thread runner([&s]() {
+            s.run();
+        });
+        s.spawn(hop(s, resumed_on));
+        std::thread::id runner_id = runner.get_id();
+        runner.join();
+
+        CHECK(resumed_on == runner_id);
+    }
+}
@@ -3,10 +3,27 @@
 
 #include "atomic/atomic_push_queue_test.h"
 #include "atomic/atomic_unique_ptr_test.h"
+#include "atomic/atomic_tagged_ptr_test.h"
+#include "atomic/epoch_test.h"
 #include "threading/inter_thread_queue_test.h"
+#include "threading/bounded_queue_test.h"
+#include "threading/work_stealing_deque_test.h"
+#include "threading/thread_pool_test.h"
+#include "threading/fan_in_queue_test.h"
 #include "collections/span_test.h"
 #include "collections/arrays_test.h"
+#include "collections/arrays_tiled_test.h"
+#include "collections/mapped_arrays_test.h"
+#include "collections/column_kernels_test.h"
+#include "collections/parallel_arrays_test.h"
 #include "collections/unordered_vector_test.h"
+#include "collections/slot_vector_test.h"
 #include "utility/observable_test.h"
 #include "utility/unique_link_test.h"
 #include "threading/semaphore_test.h"
+
+#ifdef __cpp_impl_coroutine
+#include "coroutine/scheduler_test.h"
+#include "coroutine/async_semaphore_test.h"
+#include "coroutine/async_queue_test.h"
+#endif
@@ -0,0 +1,82 @@
+#include <doctest.h>
+
+#include <thread>
+#include <vector>
+
+#include "source/fast/threading/bounded_queue.h"
+
+TEST_SUITE("bounded_queue") {
+    TEST_CASE("capacity should be rounded up to a power of two") {
+        CHECK(fast::bounded_queue<int>(1).capacity() == 2);
+        CHECK(fast::bounded_queue<int>(5).capacity() == 8);
+        CHECK(fast::bounded_queue<int>(16).capacity() == 16);
+    }
+
+    TEST_CASE("try_pop should retreive elements in correct order") {
+        fast::bounded_queue<int> queue(4);
+
+        int number = 5;
+        CHECK(queue.try_pop(number) == false);
+        CHECK(number == 5);
+
+        for (int round = 0; round < 3; round++) {
+            for (int i = 0; i < 4; i++) {
+                CHECK(queue.try_push(i) == true);
+            }
+
+            for (int i = 0; i < 4; i++) {
+                CHECK(queue.try_pop(number) == true);
+                CHECK(number == i);
+            }
+        }
+    }
+
+    TEST_CASE("try_push should fail when the queue is full") {
+        fast::bounded_queue<int> queue(2);
+
+        CHECK(queue.try_push(1) == true);
+        CHECK(queue.try_push(2) == true);
+        CHECK(queue.try_push(3) == false);
+
+        int number;
+        queue.try_pop(number);
+        CHECK(queue.try_push(3) == true);
+    }
+
+    TEST_CASE("blocking push and pop should transfer every element once") {
+        const int producers = 3, consumers = 3, count = 1000;
+        fast::bounded_queue<int> queue(8);
+        std::vector<std::thread> threads;
+        std::vector<std::atomic_int> received(producers * count);
+
+        for (auto& r : received) {
+            r = 0;
+        }
+
+        for (int p = 0; p < producers; p++) {
+            threads.emplace_back([&queue, p]() {
+                for (int i = 0; i < count; i++) {
+                    queue.push(p * count + i);
+                }
+            });
+        }
+
+        for (int c = 0; c < consumers; c++) {
+            threads.emplace_back([&queue, &received]() {
+                int number;
+                for (int i = 0; i < count; i++) {
+                    queue.pop(number);
+                    received[number]++;
+                }
+            });
+        }
+
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        for (auto& r : received) {
+            CHECK(r == 1);
+        }
+    }
+}
@@ -0,0 +1,121 @@
+#include <doctest.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "source/fast/threading/fan_in_queue.h"
+
+TEST_SUITE("fan_in_queue") {
+    TEST_CASE("try_pop should visit lanes round-robin") {
+        fast::fan_in_queue<int> queue(3);
+        auto a = queue.add_producer();
+        auto b = queue.add_producer();
+        auto c = queue.add_producer();
+        CHECK(queue.producers() == 3);
+
+        int number = 0;
+        CHECK(queue.try_pop(number) == false);
+
+        for (int i = 0; i < 2; i++) {
+            a.push(10 + i);
+            b.push(20 + i);
+            c.push(30 + i);
+        }
+
+        int expected[] = {10, 20, 30, 11, 21, 31};
+        for (int e : expected) {
+            CHECK(queue.try_pop(number) == true);
+            CHECK(number == e);
+        }
+        CHECK(queue.try_pop(number) == false);
+
+        // a lane that was drained has to be found again
+        b.emplace(22);
+        CHECK(queue.try_pop(number) == true);
+        CHECK(number == 22);
+    }
+
+    TEST_CASE("consume_all should take every available element") {
+        fast::fan_in_queue<int> queue(70);
+        std::vector<fast::fan_in_queue<int>::producer> producers;
+        for (int i = 0; i < 70; i++) {
+            producers.push_back(queue.add_producer());
+        }
+
+        // lanes in both words of the ready mask
+        producers[1].push(1);
+        producers[1].push(2);
+        producers[65].push(3);
+
+        int sum = 0;
+        CHECK(queue.consume_all([&sum](int& i) { sum += i; }) == 3);
+        CHECK(sum == 6);
+        CHECK(queue.consume_all([&sum](int& i) { sum += i; }) == 0);
+
+        producers[69].push(4);
+        CHECK(queue.consume_all([&sum](int& i) { sum += i; }) == 1);
+        CHECK(sum == 10);
+    }
+
+    TEST_CASE("wait_for should time out without elements") {
+        fast::fan_in_queue<int> queue(1);
+        auto p = queue.add_producer();
+
+        CHECK(queue.wait_for(std::chrono::milliseconds(1)) == false);
+
+        p.push(1);
+        CHECK(queue.wait_for(std::chrono::milliseconds(1)) == true);
+    }
+
+    TEST_CASE("consumer should receive every element of every producer") {
+        const int producers = 4, count = 5000;
+        fast::fan_in_queue<int> queue(producers);
+        std::vector<std::thread> threads;
+
+        for (int p = 0; p < producers; p++) {
+            threads.emplace_back([&queue, p]() {
+                auto producer = queue.add_producer();
+                for (int i = 0; i < count; i++) {
+                    producer.push(p * count + i);
+                }
+            });
+        }
+
+        // elements of one producer arrive in order
+        std::vector<int> last(producers, -1);
+        int received = 0;
+        bool ordered = true;
+        while (received < producers * count) {
+            queue.wait();
+            received += static_cast<int>(queue.consume_all([&](int& i) {
+                ordered = ordered && i % count > last[i / count];
+                last[i / count] = i % count;
+            }));
+        }
+
+        for (auto& t : threads) {
+            t.join();
+        }
+        CHECK(ordered);
+        CHECK(received == producers * count);
+    }
+
+    TEST_CASE("add_producer should fail beyond the producer limit") {
+        fast::fan_in_queue<int> queue(2);
+        auto a = queue.add_producer();
+        auto b = queue.add_producer();
+        CHECK(a.valid());
+        CHECK(b.valid());
+
+        auto c = queue.add_producer();
+        CHECK(!c.valid());
+        CHECK(!queue.add_producer().valid());
+
+        a.push(1);
+        int number = 0;
+        CHECK(queue.try_pop(number) == true);
+        CHECK(number == 1);
+        CHECK(queue.try_pop(number) == false);
+    }
+}
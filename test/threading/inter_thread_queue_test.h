@@ -1,5 +1,11 @@
 #include <doctest.h>
 
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <string>
+
 #include "source/fast/threading/inter_thread_queue.h"
 
 TEST_SUITE("inter_thread_queue") {
@@ -46,4 +52,238 @@ TEST_SUITE("inter_thread_queue") {
 
         CHECK(queue.pop() == false);
     }
+
+    TEST_CASE("available should return the number of elements") {
+        fast::inter_thread_queue<int> queue(2);
+
+        CHECK(queue.available() == 0);
+
+        for (int i = 0; i < 5; i++) {
+            queue.push(i);
+        }
+        CHECK(queue.available() == 5);
+
+        queue.pop();
+        queue.pop();
+        CHECK(queue.available() == 3);
+    }
+
+    TEST_CASE("wait_pop should wait for the producer") {
+        fast::inter_thread_queue<int> queue;
+
+        std::thread producer([&queue]() {
+            for (int i = 0; i < 1000; i++) {
+                if (i % 100 == 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                queue.push(i);
+            }
+        });
+
+        int number;
+        for (int i = 0; i < 1000; i++) {
+            queue.wait_pop(number);
+            CHECK(number == i);
+        }
+
+        producer.join();
+    }
+
+    TEST_CASE("wait_pop_for should time out on an empty queue") {
+        fast::inter_thread_queue<int> queue;
+
+        int number = 5;
+        auto timeout = std::chrono::milliseconds(1);
+        CHECK(queue.wait_pop_for(number, timeout) == false);
+        CHECK(number == 5);
+
+        queue.push(7);
+        CHECK(queue.wait_pop_for(number, timeout) == true);
+        CHECK(number == 7);
+    }
+
+    TEST_CASE("push_n should push all elements in order") {
+        fast::inter_thread_queue<int> queue(2);
+        std::vector<int> numbers {1, 2, 3, 4, 5};
+
+        CHECK(queue.push(0) == false);
+        CHECK(queue.push_n(
+            fast::span<int>(numbers.data(), numbers.data() + numbers.size())
+        ) == true);
+        CHECK(queue.available() == 6);
+
+        for (int i = 0; i < 6; i++) {
+            CHECK(queue.top() == i);
+            queue.pop();
+        }
+    }
+
+    TEST_CASE("readable should return contiguous elements of one block") {
+        fast::inter_thread_queue<int> queue(4);
+
+        CHECK(queue.readable().begin() == queue.readable().end());
+
+        for (int i = 0; i < 10; i++) {
+            queue.push(i);
+        }
+
+        int next = 0;
+        while (next < 10) {
+            fast::span<int> items = queue.readable();
+            std::size_t size = items.end() - items.begin();
+            CHECK(size > 0);
+            CHECK(size <= 4);
+
+            for (int i : items) {
+                CHECK(i == next);
+                next++;
+            }
+            CHECK(queue.pop_n(size) == (next < 10));
+        }
+
+        CHECK(queue.available() == 0);
+    }
+
+    TEST_CASE("stats should count growth") {
+        fast::inter_thread_queue<int> queue(4);
+
+        auto stats = queue.stats();
+        CHECK(stats.blocks == 1);
+        CHECK(stats.grow_events == 0);
+        CHECK(stats.allocated_bytes >= 4 * sizeof(int));
+
+        for (int i = 0; i < 100; i++) {
+            queue.push(i);
+        }
+
+        stats = queue.stats();
+        CHECK(stats.grow_events > 0);
+        CHECK(stats.blocks == stats.grow_events + 1);
+        CHECK(stats.peak_size == 100);
+        CHECK(stats.allocated_bytes >= 100 * sizeof(int));
+    }
+
+    TEST_CASE("trim should free drained blocks") {
+        fast::inter_thread_queue<int> queue(4);
+
+        for (int i = 0; i < 100; i++) {
+            queue.push(i);
+        }
+        for (int i = 0; i < 100; i++) {
+            queue.pop();
+        }
+
+        auto grown = queue.stats();
+        CHECK(queue.trim() == grown.blocks - 1);
+
+        auto trimmed = queue.stats();
+        CHECK(trimmed.blocks == 1);
+        CHECK(trimmed.allocated_bytes < grown.allocated_bytes);
+
+        for (int i = 0; i < 100; i++) {
+            queue.push(i);
+        }
+        for (int i = 0; i < 100; i++) {
+            CHECK(queue.top() == i);
+            queue.pop();
+        }
+    }
+
+    TEST_CASE("trim should keep blocks with elements") {
+        fast::inter_thread_queue<int> queue(2);
+
+        for (int i = 0; i < 20; i++) {
+            queue.push(i);
+        }
+        for (int i = 0; i < 10; i++) {
+            queue.pop();
+        }
+
+        queue.trim();
+
+        for (int i = 10; i < 20; i++) {
+            CHECK(queue.top() == i);
+            queue.pop();
+        }
+    }
+
+    TEST_CASE("queue should work with move-only types") {
+        fast::inter_thread_queue<std::unique_ptr<int>> queue(2);
+
+        for (int i = 0; i < 5; i++) {
+            queue.push(std::unique_ptr<int>(new int(i)));
+        }
+
+        std::unique_ptr<int> value;
+        for (int i = 0; i < 5; i++) {
+            queue.wait_pop(value);
+            CHECK(*value == i);
+        }
+    }
+
+    TEST_CASE("emplace should construct elements in place") {
+        struct pair {
+            pair(int a, std::string b) : a(a), b(b) {}
+            int a;
+            std::string b;
+        };
+        fast::inter_thread_queue<pair> queue;
+
+        queue.emplace(1, "one");
+        pair p(2, "two");
+        queue.push(p);
+
+        CHECK(queue.top().a == 1);
+        CHECK(queue.top().b == "one");
+        queue.pop();
+        CHECK(queue.top().a == 2);
+        CHECK(queue.top().b == "two");
+        queue.pop();
+    }
+
+    TEST_CASE("elements should only be alive while in the queue") {
+        static int alive = 0;
+        struct counted {
+            counted() { alive++; }
+            counted(const counted&) { alive++; }
+            ~counted() { alive--; }
+        };
+
+        {
+            fast::inter_thread_queue<counted> queue(4);
+            CHECK(alive == 0);
+
+            for (int i = 0; i < 10; i++) {
+                queue.emplace();
+            }
+            CHECK(alive == 10);
+
+            queue.pop_n(4);
+            CHECK(alive == 6);
+        }
+        CHECK(alive == 0);
+    }
+
+    TEST_CASE("contention counters should only count when enabled") {
+        fast::inter_thread_queue<int> queue(2);
+
+        CHECK(queue.available() == 0);
+        for (int i = 0; i < 5; i++) {
+            queue.push(i);
+        }
+
+        fast::contention_snapshot counters = queue.contention();
+#if FAST_CONTENTION_COUNTERS
+        CHECK(counters.empty_polls == 1);
+        // blocks of 2 and 4 elements were added to the first one
+        CHECK(counters.block_allocations == 2);
+        CHECK(counters.peak_depth == 5);
+#else
+        CHECK(counters.empty_polls == 0);
+        CHECK(counters.block_allocations == 0);
+        CHECK(counters.peak_depth == 0);
+#endif
+        CHECK(counters.cas_retries == 0);
+        CHECK(counters.swap_failures == 0);
+    }
 }
@@ -2,6 +2,8 @@
 
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <vector>
 
 #include "source/fast/threading/semaphore.h"
 
@@ -28,4 +30,90 @@ TEST_SUITE("semaphore") {
 
         waiter.join();
     }
+
+    TEST_CASE("try_wait should only succeed while the count is positive") {
+        fast::semaphore s(2);
+
+        CHECK(s.try_wait() == true);
+        CHECK(s.try_wait() == true);
+        CHECK(s.try_wait() == false);
+
+        s.signal();
+        CHECK(s.try_wait() == true);
+    }
+
+    TEST_CASE("wait_for should not decrement on timeout") {
+        fast::semaphore s;
+
+        CHECK(s.wait_for(10) == false);
+        CHECK(s.wait_for(std::chrono::microseconds(100)) == false);
+
+        // a timed out wait must not have consumed this
+        s.signal();
+        CHECK(s.wait_for(0) == true);
+        CHECK(s.try_wait() == false);
+    }
+
+    TEST_CASE("wait_for should return once signaled") {
+        fast::semaphore s;
+
+        std::thread signaler([&s]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            s.signal();
+        });
+
+        CHECK(s.wait_for(std::chrono::seconds(10)) == true);
+        signaler.join();
+    }
+
+    TEST_CASE("signal with a count should wake that many waiters") {
+        const int waiters = 4;
+        fast::semaphore s;
+        std::atomic_int woken(0);
+        std::vector<std::thread> threads;
+
+        for (int i = 0; i < waiters; i++) {
+            threads.emplace_back([&]() {
+                s.wait();
+                woken++;
+            });
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        s.signal(waiters - 1);
+        s.signal();
+
+        for (auto& t : threads) {
+            t.join();
+        }
+        CHECK(woken == waiters);
+        CHECK(s.try_wait() == false);
+    }
+
+    TEST_CASE("count should be kept under contention with timeouts") {
+        const int threads_count = 4, count = 2000;
+        fast::semaphore s;
+        std::atomic_int taken(0);
+        std::vector<std::thread> threads;
+
+        for (int i = 0; i < threads_count; i++) {
+            threads.emplace_back([&]() {
+                while (taken.load() < count) {
+                    if (s.wait_for(std::chrono::microseconds(50))) {
+                        taken++;
+                    }
+                }
+            });
+        }
+
+        for (int i = 0; i < count; i++) {
+            s.signal();
+        }
+
+        for (auto& t : threads) {
+            t.join();
+        }
+        CHECK(taken == count);
+        CHECK(s.try_wait() == false);
+    }
 }
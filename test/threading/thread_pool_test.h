@@ -0,0 +1,82 @@
+#include <doctest.h>
+
+#include <atomic>
+#include <vector>
+
+#include "source/fast/threading/thread_pool.h"
+
+TEST_SUITE("thread_pool") {
+    TEST_CASE("submit should run every task") {
+        std::atomic_int count(0);
+        {
+            fast::thread_pool pool(3, 4);
+            CHECK(pool.size() == 3);
+
+            for (int i = 0; i < 1000; i++) {
+                pool.submit([&count]() {
+                    count++;
+                });
+            }
+        }
+        CHECK(count == 1000);
+    }
+
+    TEST_CASE("tasks submitted by tasks should run before destruction") {
+        std::atomic_int count(0);
+        {
+            fast::thread_pool pool(2);
+
+            for (int i = 0; i < 10; i++) {
+                pool.submit([&pool, &count]() {
+                    for (int j = 0; j < 100; j++) {
+                        pool.submit([&count]() {
+                            count++;
+                        });
+                    }
+                });
+            }
+        }
+        CHECK(count == 1000);
+    }
+
+    TEST_CASE("parallel_for should visit every index once") {
+        fast::thread_pool pool(4);
+        std::vector<std::atomic_int> visited(1000);
+
+        for (auto& v : visited) {
+            v = 0;
+        }
+
+        pool.parallel_for(0, visited.size(), [&visited](std::size_t i) {
+            visited[i]++;
+        });
+
+        for (auto& v : visited) {
+            CHECK(v == 1);
+        }
+
+        // empty range and grain larger than the range
+        pool.parallel_for(5, 5, [&visited](std::size_t i) {
+            visited[i]++;
+        });
+        pool.parallel_for(0, 10, [&visited](std::size_t i) {
+            visited[i]++;
+        }, 100);
+        CHECK(visited[0] == 2);
+        CHECK(visited[9] == 2);
+        CHECK(visited[10] == 1);
+    }
+
+    TEST_CASE("parallel_for should work when nested in a task") {
+        fast::thread_pool pool(2);
+        std::atomic_int sum(0);
+
+        pool.parallel_for(0, 8, [&pool, &sum](std::size_t) {
+            pool.parallel_for(0, 8, [&sum](std::size_t j) {
+                sum += static_cast<int>(j);
+            }, 1);
+        }, 1);
+
+        CHECK(sum == 8 * 28);
+    }
+}
@@ -0,0 +1,80 @@
+#include <doctest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "source/fast/threading/work_stealing_deque.h"
+
+TEST_SUITE("work_stealing_deque") {
+    TEST_CASE("take should return the newest and steal the oldest element") {
+        fast::work_stealing_deque<int> deque(2);
+
+        int number = 0;
+        CHECK(deque.empty());
+        CHECK(deque.take(number) == false);
+        CHECK(deque.steal(number) == false);
+
+        // grows past the initial capacity
+        for (int i = 0; i < 10; i++) {
+            deque.push(i);
+        }
+        CHECK(!deque.empty());
+
+        CHECK(deque.take(number) == true);
+        CHECK(number == 9);
+        CHECK(deque.steal(number) == true);
+        CHECK(number == 0);
+
+        for (int i = 8; i > 0; i--) {
+            CHECK(deque.take(number) == true);
+            CHECK(number == i);
+        }
+        CHECK(deque.take(number) == false);
+        CHECK(deque.empty());
+    }
+
+    TEST_CASE("every element should be taken or stolen exactly once") {
+        const int thieves = 3, count = 20000;
+        fast::work_stealing_deque<int> deque(4);
+        std::vector<std::atomic_int> received(count);
+        std::atomic_bool done(false);
+        std::vector<std::thread> threads;
+
+        for (auto& r : received) {
+            r = 0;
+        }
+
+        for (int t = 0; t < thieves; t++) {
+            threads.emplace_back([&]() {
+                int number;
+                while (!done.load() || !deque.empty()) {
+                    if (deque.steal(number)) {
+                        received[number]++;
+                    }
+                }
+            });
+        }
+
+        int number;
+        for (int i = 0; i < count; i++) {
+            deque.push(i);
+            if (i % 3 == 0 && deque.take(number)) {
+                received[number]++;
+            }
+        }
+        done = true;
+
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        while (deque.take(number)) {
+            received[number]++;
+        }
+
+        for (auto& r : received) {
+            CHECK(r == 1);
+        }
+    }
+}